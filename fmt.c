@@ -6,14 +6,18 @@
 #include "fmt.h"
 #include "fmtlib.h"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "OCDFAInspection"
 
 #define min(a, b) ((a) < (b) ? (a) : (b))
 #define max(a, b) ((a) > (b) ? (a) : (b))
 #define is_digit(ch) ((ch) >= '0' && (ch) <= '9')
-#define is_alpha(ch) (((ch) >= 'a' && (ch) <= 'z') || ((ch) >= 'A' && (ch) <= 'Z'))
-#define is_align(ch) ((ch) == '<' || (ch) == '^' || (ch) == '>')
 
 typedef struct parsed_fmt_spec {
   int index;
@@ -29,6 +33,60 @@ typedef struct parsed_fmt_spec {
   bool valid;
 } parsed_fmt_spec_t;
 
+// returns a pointer to the first '{', '}', '%' or null character at or after ptr.
+// the vectorized versions only use aligned loads so they never read across a page
+// boundary past the end of the string, but they may read bytes before ptr and after
+// the null terminator so they are excluded from address sanitizing.
+__attribute__((no_sanitize_address))
+static inline const char *scan_literal(const char *ptr) {
+#if defined(__AVX2__)
+  const __m256i lbrace = _mm256_set1_epi8('{');
+  const __m256i rbrace = _mm256_set1_epi8('}');
+  const __m256i percent = _mm256_set1_epi8('%');
+  const __m256i zero = _mm256_setzero_si256();
+
+  uintptr_t offset = (uintptr_t) ptr & 31;
+  const __m256i *block = (const __m256i *) (ptr - offset);
+  uint32_t mask = ~0u << offset;
+  for (;;) {
+    __m256i v = _mm256_load_si256(block);
+    __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, lbrace), _mm256_cmpeq_epi8(v, rbrace)),
+                                _mm256_or_si256(_mm256_cmpeq_epi8(v, percent), _mm256_cmpeq_epi8(v, zero)));
+    mask &= (uint32_t) _mm256_movemask_epi8(m);
+    if (mask != 0)
+      return (const char *) block + __builtin_ctz(mask);
+
+    block++;
+    mask = ~0u;
+  }
+#elif defined(__SSE2__)
+  const __m128i lbrace = _mm_set1_epi8('{');
+  const __m128i rbrace = _mm_set1_epi8('}');
+  const __m128i percent = _mm_set1_epi8('%');
+  const __m128i zero = _mm_setzero_si128();
+
+  uintptr_t offset = (uintptr_t) ptr & 15;
+  const __m128i *block = (const __m128i *) (ptr - offset);
+  uint32_t mask = 0xFFFFu << offset;
+  for (;;) {
+    __m128i v = _mm_load_si128(block);
+    __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, lbrace), _mm_cmpeq_epi8(v, rbrace)),
+                             _mm_or_si128(_mm_cmpeq_epi8(v, percent), _mm_cmpeq_epi8(v, zero)));
+    mask &= (uint32_t) _mm_movemask_epi8(m);
+    if (mask != 0)
+      return (const char *) block + __builtin_ctz(mask);
+
+    block++;
+    mask = 0xFFFFu;
+  }
+#else
+  while (*ptr && *ptr != '{' && *ptr != '}' && *ptr != '%') {
+    ptr++;
+  }
+  return ptr;
+#endif
+}
+
 static inline int read_int(const char **ptr) {
   const char *start = *ptr;
   while (is_digit(**ptr)) {
@@ -37,42 +95,274 @@ static inline int read_int(const char **ptr) {
 
   size_t size = *ptr - start;
   int value = 0;
-  int sign = 1;
-  if (start[0] == '-') {
-    sign = -1;
-    start++;
-    size--;
-  }
-
   for (size_t i = 0; i < size; i++) {
     value *= 10;
     value += start[i] - '0';
   }
-  return sign * value;
+  return value;
 }
 
-// parses fmt '{...}' specifiers
-static inline size_t parse_fmt_spec(const char *format, int max_args, int *arg_index, int *arg_count, parsed_fmt_spec_t *spec) {
-#define CHECK_MAX_ARGS(idx) ({ \
-    if ((idx) >= max_args) {  \
-      goto early_exit;            \
-    }                             \
-  })
-#define CHECK_EOF(ptr) ({ \
-    if (*(ptr) == '}')    \
-      goto parse_type;    \
-    if (*(ptr) == 0)      \
-      goto early_exit;    \
-  })
-
-  if (*format != '{') {
-    return 0;
-  }
-
-  // {[index]:[[$fill]align][flags][width][.precision][type]}
-  // ^ format
-  const char *start;
+// MARK: Specifier parser
+//
+// both specifier syntaxes are parsed by the same table-driven state machine. every
+// character is first mapped to a class, and the class together with the current state
+// selects an action and the next state from the transition table. the two dialects only
+// differ in their states, so the shared parts like flags, width and precision are handled
+// by the same actions.
+//
+//   {[index]:[[$fill]align][flags][width][.precision][type]}
+//   %[flags][width][.precision]type
+
+// character classes
+enum {
+  C_OTHER,
+  C_NUL,
+  C_DIGIT,  // 1-9
+  C_ZERO,   // 0 is a digit everywhere but in the flags
+  C_RBRACE,
+  C_COLON,
+  C_DOLLAR,
+  C_ALIGN,  // < ^ >
+  C_FLAG,   // # + - space
+  C_BANG,   // ! is only a flag in the '{' syntax
+  C_STAR,
+  C_DOT,
+  NUM_CLASSES
+};
+
+// parser states
+enum {
+  S_INDEX,        // {|
+  S_AFTER_INDEX,  // {0|
+  S_SPEC,         // {0:|
+  S_FILL,         // {0:$|
+  S_FILL_ALIGN,   // {0:$x|
+  S_FLAGS,        // {0:>|  {0:#|
+  S_WIDTH_STAR,   // {0:*|
+  S_PREC_OPT,     // {0:10|
+  S_PREC_VALUE,   // {0:.|
+  S_PREC_STAR,    // {0:.*|
+  S_TYPE,         // {0:.2|
+  S_P_FLAGS,      // %|  %#|
+  S_P_PREC_OPT,   // %10|
+  S_P_PREC_VALUE, // %.|
+  S_P_TYPE,       // %.2|
+  NUM_STATES
+};
+
+// actions
+enum {
+  A_ERROR,              // invalid specifier
+  A_SKIP,               // consume the character
+  A_INDEX,              // read the argument index
+  A_IMPLICIT_INDEX,     // use the next implicit argument index
+  A_FILL,               // read the fill character
+  A_ALIGN,              // read the alignment
+  A_FLAG,               // read a flag
+  A_WIDTH,              // read the width
+  A_WIDTH_INDEX,        // read the width argument index
+  A_WIDTH_IMPLICIT,     // use the next implicit argument index for the width
+  A_PRECISION,          // read the precision
+  A_PRECISION_INDEX,    // read the precision argument index
+  A_PRECISION_IMPLICIT, // use the next implicit argument index for the precision
+  A_TYPE,               // read the rest of a '{' specifier as the type (final)
+  A_PRINTF_TYPE,        // read a printf type (final)
+};
+
+// each transition packs the next state in the high and the action in the low nibble.
+// missing transitions are zero which is the error action.
+#define T(action, state) ((uint8_t) (((state) << 4) | (action)))
+#define T_ACTION(t) ((t) & 0xF)
+#define T_STATE(t) ((t) >> 4)
+
+static const uint8_t char_classes[256] = {
+  [0] = C_NUL,
+  ['1'] = C_DIGIT, ['2'] = C_DIGIT, ['3'] = C_DIGIT, ['4'] = C_DIGIT, ['5'] = C_DIGIT,
+  ['6'] = C_DIGIT, ['7'] = C_DIGIT, ['8'] = C_DIGIT, ['9'] = C_DIGIT,
+  ['0'] = C_ZERO,
+  ['}'] = C_RBRACE,
+  [':'] = C_COLON,
+  ['$'] = C_DOLLAR,
+  ['<'] = C_ALIGN, ['^'] = C_ALIGN, ['>'] = C_ALIGN,
+  ['#'] = C_FLAG, ['+'] = C_FLAG, ['-'] = C_FLAG, [' '] = C_FLAG,
+  ['!'] = C_BANG,
+  ['*'] = C_STAR,
+  ['.'] = C_DOT,
+};
+
+static const uint8_t transitions[NUM_STATES][NUM_CLASSES] = {
+  [S_INDEX] = {
+    [C_OTHER] = T(A_IMPLICIT_INDEX, S_AFTER_INDEX),
+    [C_DIGIT] = T(A_INDEX, S_AFTER_INDEX),
+    [C_ZERO] = T(A_INDEX, S_AFTER_INDEX),
+    [C_RBRACE] = T(A_IMPLICIT_INDEX, S_AFTER_INDEX),
+    [C_COLON] = T(A_IMPLICIT_INDEX, S_AFTER_INDEX),
+    [C_DOLLAR] = T(A_IMPLICIT_INDEX, S_AFTER_INDEX),
+    [C_ALIGN] = T(A_IMPLICIT_INDEX, S_AFTER_INDEX),
+    [C_FLAG] = T(A_IMPLICIT_INDEX, S_AFTER_INDEX),
+    [C_BANG] = T(A_IMPLICIT_INDEX, S_AFTER_INDEX),
+    [C_STAR] = T(A_IMPLICIT_INDEX, S_AFTER_INDEX),
+    [C_DOT] = T(A_IMPLICIT_INDEX, S_AFTER_INDEX),
+  },
+  [S_AFTER_INDEX] = {
+    [C_RBRACE] = T(A_TYPE, 0),
+    [C_COLON] = T(A_SKIP, S_SPEC),
+  },
+  // like S_FLAGS but also accepts the fill and alignment
+  [S_SPEC] = {
+    [C_OTHER] = T(A_TYPE, 0),
+    [C_DIGIT] = T(A_WIDTH, S_PREC_OPT),
+    [C_ZERO] = T(A_FLAG, S_FLAGS),
+    [C_RBRACE] = T(A_TYPE, 0),
+    [C_COLON] = T(A_TYPE, 0),
+    [C_DOLLAR] = T(A_SKIP, S_FILL),
+    [C_ALIGN] = T(A_ALIGN, S_FLAGS),
+    [C_FLAG] = T(A_FLAG, S_FLAGS),
+    [C_BANG] = T(A_FLAG, S_FLAGS),
+    [C_STAR] = T(A_SKIP, S_WIDTH_STAR),
+    [C_DOT] = T(A_SKIP, S_PREC_VALUE),
+  },
+  [S_FILL] = {
+    [C_OTHER] = T(A_FILL, S_FILL_ALIGN),
+    [C_DIGIT] = T(A_FILL, S_FILL_ALIGN),
+    [C_ZERO] = T(A_FILL, S_FILL_ALIGN),
+    [C_RBRACE] = T(A_FILL, S_FILL_ALIGN),
+    [C_COLON] = T(A_FILL, S_FILL_ALIGN),
+    [C_DOLLAR] = T(A_FILL, S_FILL_ALIGN),
+    [C_ALIGN] = T(A_FILL, S_FILL_ALIGN),
+    [C_FLAG] = T(A_FILL, S_FILL_ALIGN),
+    [C_BANG] = T(A_FILL, S_FILL_ALIGN),
+    [C_STAR] = T(A_FILL, S_FILL_ALIGN),
+    [C_DOT] = T(A_FILL, S_FILL_ALIGN),
+  },
+  [S_FILL_ALIGN] = {
+    [C_ALIGN] = T(A_ALIGN, S_FLAGS),
+  },
+  [S_FLAGS] = {
+    [C_OTHER] = T(A_TYPE, 0),
+    [C_DIGIT] = T(A_WIDTH, S_PREC_OPT),
+    [C_ZERO] = T(A_FLAG, S_FLAGS),
+    [C_RBRACE] = T(A_TYPE, 0),
+    [C_COLON] = T(A_TYPE, 0),
+    [C_DOLLAR] = T(A_TYPE, 0),
+    [C_ALIGN] = T(A_TYPE, 0),
+    [C_FLAG] = T(A_FLAG, S_FLAGS),
+    [C_BANG] = T(A_FLAG, S_FLAGS),
+    [C_STAR] = T(A_SKIP, S_WIDTH_STAR),
+    [C_DOT] = T(A_SKIP, S_PREC_VALUE),
+  },
+  [S_WIDTH_STAR] = {
+    [C_OTHER] = T(A_WIDTH_IMPLICIT, S_PREC_OPT),
+    [C_DIGIT] = T(A_WIDTH_INDEX, S_PREC_OPT),
+    [C_ZERO] = T(A_WIDTH_INDEX, S_PREC_OPT),
+    [C_RBRACE] = T(A_WIDTH_IMPLICIT, S_PREC_OPT),
+    [C_COLON] = T(A_WIDTH_IMPLICIT, S_PREC_OPT),
+    [C_DOLLAR] = T(A_WIDTH_IMPLICIT, S_PREC_OPT),
+    [C_ALIGN] = T(A_WIDTH_IMPLICIT, S_PREC_OPT),
+    [C_FLAG] = T(A_WIDTH_IMPLICIT, S_PREC_OPT),
+    [C_BANG] = T(A_WIDTH_IMPLICIT, S_PREC_OPT),
+    [C_STAR] = T(A_WIDTH_IMPLICIT, S_PREC_OPT),
+    [C_DOT] = T(A_WIDTH_IMPLICIT, S_PREC_OPT),
+  },
+  [S_PREC_OPT] = {
+    [C_OTHER] = T(A_TYPE, 0),
+    [C_DIGIT] = T(A_TYPE, 0),
+    [C_ZERO] = T(A_TYPE, 0),
+    [C_RBRACE] = T(A_TYPE, 0),
+    [C_COLON] = T(A_TYPE, 0),
+    [C_DOLLAR] = T(A_TYPE, 0),
+    [C_ALIGN] = T(A_TYPE, 0),
+    [C_FLAG] = T(A_TYPE, 0),
+    [C_BANG] = T(A_TYPE, 0),
+    [C_STAR] = T(A_TYPE, 0),
+    [C_DOT] = T(A_SKIP, S_PREC_VALUE),
+  },
+  [S_PREC_VALUE] = {
+    [C_DIGIT] = T(A_PRECISION, S_TYPE),
+    [C_ZERO] = T(A_PRECISION, S_TYPE),
+    [C_STAR] = T(A_SKIP, S_PREC_STAR),
+  },
+  [S_PREC_STAR] = {
+    [C_OTHER] = T(A_PRECISION_IMPLICIT, S_TYPE),
+    [C_DIGIT] = T(A_PRECISION_INDEX, S_TYPE),
+    [C_ZERO] = T(A_PRECISION_INDEX, S_TYPE),
+    [C_RBRACE] = T(A_PRECISION_IMPLICIT, S_TYPE),
+    [C_COLON] = T(A_PRECISION_IMPLICIT, S_TYPE),
+    [C_DOLLAR] = T(A_PRECISION_IMPLICIT, S_TYPE),
+    [C_ALIGN] = T(A_PRECISION_IMPLICIT, S_TYPE),
+    [C_FLAG] = T(A_PRECISION_IMPLICIT, S_TYPE),
+    [C_BANG] = T(A_PRECISION_IMPLICIT, S_TYPE),
+    [C_STAR] = T(A_PRECISION_IMPLICIT, S_TYPE),
+    [C_DOT] = T(A_PRECISION_IMPLICIT, S_TYPE),
+  },
+  [S_TYPE] = {
+    [C_OTHER] = T(A_TYPE, 0),
+    [C_NUL] = T(A_TYPE, 0),
+    [C_DIGIT] = T(A_TYPE, 0),
+    [C_ZERO] = T(A_TYPE, 0),
+    [C_RBRACE] = T(A_TYPE, 0),
+    [C_COLON] = T(A_TYPE, 0),
+    [C_DOLLAR] = T(A_TYPE, 0),
+    [C_ALIGN] = T(A_TYPE, 0),
+    [C_FLAG] = T(A_TYPE, 0),
+    [C_BANG] = T(A_TYPE, 0),
+    [C_STAR] = T(A_TYPE, 0),
+    [C_DOT] = T(A_TYPE, 0),
+  },
+  [S_P_FLAGS] = {
+    [C_OTHER] = T(A_PRINTF_TYPE, 0),
+    [C_DIGIT] = T(A_WIDTH, S_P_PREC_OPT),
+    [C_ZERO] = T(A_FLAG, S_P_FLAGS),
+    [C_RBRACE] = T(A_PRINTF_TYPE, 0),
+    [C_COLON] = T(A_PRINTF_TYPE, 0),
+    [C_DOLLAR] = T(A_PRINTF_TYPE, 0),
+    [C_ALIGN] = T(A_PRINTF_TYPE, 0),
+    [C_FLAG] = T(A_FLAG, S_P_FLAGS),
+    [C_BANG] = T(A_PRINTF_TYPE, 0),
+    [C_STAR] = T(A_PRINTF_TYPE, 0),
+    [C_DOT] = T(A_SKIP, S_P_PREC_VALUE),
+  },
+  [S_P_PREC_OPT] = {
+    [C_OTHER] = T(A_PRINTF_TYPE, 0),
+    [C_DIGIT] = T(A_PRINTF_TYPE, 0),
+    [C_ZERO] = T(A_PRINTF_TYPE, 0),
+    [C_RBRACE] = T(A_PRINTF_TYPE, 0),
+    [C_COLON] = T(A_PRINTF_TYPE, 0),
+    [C_DOLLAR] = T(A_PRINTF_TYPE, 0),
+    [C_ALIGN] = T(A_PRINTF_TYPE, 0),
+    [C_FLAG] = T(A_PRINTF_TYPE, 0),
+    [C_BANG] = T(A_PRINTF_TYPE, 0),
+    [C_STAR] = T(A_PRINTF_TYPE, 0),
+    [C_DOT] = T(A_SKIP, S_P_PREC_VALUE),
+  },
+  [S_P_PREC_VALUE] = {
+    [C_DIGIT] = T(A_PRECISION, S_P_TYPE),
+    [C_ZERO] = T(A_PRECISION, S_P_TYPE),
+  },
+  [S_P_TYPE] = {
+    [C_OTHER] = T(A_PRINTF_TYPE, 0),
+    [C_NUL] = T(A_PRINTF_TYPE, 0),
+    [C_DIGIT] = T(A_PRINTF_TYPE, 0),
+    [C_ZERO] = T(A_PRINTF_TYPE, 0),
+    [C_RBRACE] = T(A_PRINTF_TYPE, 0),
+    [C_COLON] = T(A_PRINTF_TYPE, 0),
+    [C_DOLLAR] = T(A_PRINTF_TYPE, 0),
+    [C_ALIGN] = T(A_PRINTF_TYPE, 0),
+    [C_FLAG] = T(A_PRINTF_TYPE, 0),
+    [C_BANG] = T(A_PRINTF_TYPE, 0),
+    [C_STAR] = T(A_PRINTF_TYPE, 0),
+    [C_DOT] = T(A_PRINTF_TYPE, 0),
+  },
+};
+
+// runs the parser from the given state on the specifier starting after its '{' or '%'.
+// on success the spec is filled in, arg_index and arg_count are updated and the length
+// of the specifier is returned. on failure spec->valid is false and the returned length
+// is how much of the format string to skip.
+static inline size_t parse_spec(const char *format, int state, int max_args, int *arg_index, int *arg_count, parsed_fmt_spec_t *spec) {
   const char *ptr = format + 1;
+  const char *type = NULL;
+  const char *end = ptr;
 
   int index = 0;
   int flags = 0;
@@ -84,136 +374,109 @@ static inline size_t parse_fmt_spec(const char *format, int max_args, int *arg_i
   char fill_char = ' ';
   int new_arg_index = *arg_index;
 
-  // ====== index ======
-  CHECK_EOF(ptr);
-  if (is_digit(*ptr)) {
-    index = read_int(&ptr);
-    CHECK_MAX_ARGS(index);
-  } else {
-    CHECK_MAX_ARGS(new_arg_index);
-    index = new_arg_index;
-    new_arg_index++;
-  }
-
-  if (*ptr == '}') {
-    goto parse_type;
-  } else if (*ptr == ':') {
-    ptr++;
-  } else {
-    goto early_exit;
-  }
-
-  // quick check for fast path
-  if (is_alpha(*ptr)) {
-    goto parse_type;
-  } else if (*ptr == '0') {
-    goto parse_flags;
-  } else if (is_digit(*ptr)) {
-    goto parse_width;
-  } else if (*ptr == '.') {
-    goto parse_precision;
-  }
-
-    // ====== align ======
-  CHECK_EOF(ptr);
-  if (*ptr == '$') {
-    ptr++;
-    if (*ptr == 0)
-      goto early_exit;
-
-    fill_char = *ptr++;
-    if (!is_align(*ptr))
-      goto early_exit;
-  }
-
-  switch (*ptr) {
-    case '<': align = FMT_ALIGN_LEFT; ptr++;
-      break;
-    case '^': align = FMT_ALIGN_CENTER; ptr++;
-      break;
-    case '>': align = FMT_ALIGN_RIGHT; ptr++;
-      break;
-  }
-
-  // ====== flags ======
-  CHECK_EOF(ptr);
-  flags = 0;
-parse_flags:
-  switch (*ptr) {
-    case '#': flags |= FMT_FLAG_ALT; ptr++;
-      goto parse_flags;
-    case '!': flags |= FMT_FLAG_UPPER; ptr++;
-      goto parse_flags;
-    case '0': flags |= FMT_FLAG_ZERO; fill_char = '0'; ptr++;
-      goto parse_flags;
-    case '+': flags |= FMT_FLAG_SIGN; ptr++;
-      goto parse_flags;
-    case '-': align = FMT_ALIGN_RIGHT; ptr++; // fake flag
-      flags &= ~FMT_FLAG_ZERO;
-      goto parse_flags;
-    case ' ': flags |= FMT_FLAG_SPACE; ptr++;
-      goto parse_flags;
-  }
-
-  // ====== width ======
-  CHECK_EOF(ptr);
-parse_width:
-  if (is_digit(*ptr)) {
-    width_or_index = read_int(&ptr);
-    width_is_index = false;
-  } else if (*ptr == '*') {
-    ptr++;
-    if (*ptr == 0) {
-      goto early_exit;
-    } else if (is_digit(*ptr)) {
-      width_or_index = read_int(&ptr);
-      width_is_index = true;
-      CHECK_MAX_ARGS(width_or_index);
-    } else {
-      CHECK_MAX_ARGS(new_arg_index);
-      width_or_index = new_arg_index;
-      width_is_index = true;
-      new_arg_index++;
-    }
-  }
-
-  // ====== precision ======
-  CHECK_EOF(ptr);
-parse_precision:
-  if (*ptr == '.') {
-    ptr++;
-    if (is_digit(*ptr)) {
-      precision_or_index = read_int(&ptr);
-      precision_is_index = false;
-    } else if (*ptr == '*') {
-      ptr++;
-      if (*ptr == 0) {
-        goto early_exit;
-      } else if (is_digit(*ptr)) {
+  while (type == NULL) {
+    uint8_t t = transitions[state][char_classes[(uint8_t) *ptr]];
+    state = T_STATE(t);
+    switch (T_ACTION(t)) {
+      case A_ERROR:
+        goto error;
+      case A_SKIP:
+        ptr++;
+        break;
+      case A_INDEX:
+        index = read_int(&ptr);
+        break;
+      case A_IMPLICIT_INDEX:
+        index = new_arg_index++;
+        break;
+      case A_FILL:
+        fill_char = *ptr++;
+        break;
+      case A_ALIGN:
+        switch (*ptr++) {
+          case '<': align = FMT_ALIGN_LEFT; break;
+          case '^': align = FMT_ALIGN_CENTER; break;
+          case '>': align = FMT_ALIGN_RIGHT; break;
+        }
+        break;
+      case A_FLAG:
+        switch (*ptr++) {
+          case '#': flags |= FMT_FLAG_ALT; break;
+          case '!': flags |= FMT_FLAG_UPPER; break;
+          case '0': flags |= FMT_FLAG_ZERO; fill_char = '0'; break;
+          case '+': flags |= FMT_FLAG_SIGN; break;
+          case '-': align = FMT_ALIGN_RIGHT; flags &= ~FMT_FLAG_ZERO; break; // fake flag
+          case ' ': flags |= FMT_FLAG_SPACE; break;
+        }
+        break;
+      case A_WIDTH:
+        width_or_index = read_int(&ptr);
+        break;
+      case A_WIDTH_INDEX:
+        width_or_index = read_int(&ptr);
+        width_is_index = true;
+        break;
+      case A_WIDTH_IMPLICIT:
+        width_or_index = new_arg_index++;
+        width_is_index = true;
+        break;
+      case A_PRECISION:
+        precision_or_index = read_int(&ptr);
+        break;
+      case A_PRECISION_INDEX:
         precision_or_index = read_int(&ptr);
         precision_is_index = true;
-        CHECK_MAX_ARGS(precision_or_index);
-      } else {
-        CHECK_MAX_ARGS(new_arg_index);
-        precision_or_index = new_arg_index;
+        break;
+      case A_PRECISION_IMPLICIT:
+        precision_or_index = new_arg_index++;
         precision_is_index = true;
-        new_arg_index++;
-      }
-    } else {
-      goto early_exit;
+        break;
+      case A_TYPE:
+        type = ptr;
+        while (*ptr && *ptr != '}') {
+          ptr++;
+        }
+        if (*ptr == 0)
+          goto error;
+        end = ptr + 1;
+        break;
+      case A_PRINTF_TYPE:
+        // we have built-in types like "lld" and "zx" which implicity encode the length
+        // in a backward compatible-way so we don't need to parse the length specifier
+        // separately.
+        if (!fmtlib_parse_printf_type(ptr, &end))
+          goto error;
+        // %g uses 6 significant digits by default like printf while {:g} without
+        // a precision writes the shortest digits
+        if ((end[-1] == 'g' || end[-1] == 'G') && !precision_is_index && precision_or_index == 0)
+          precision_or_index = 6;
+        index = new_arg_index++;
+        type = ptr;
+        ptr = end;
+        break;
     }
   }
 
-  // ====== type ======
-parse_type:
-  start = ptr;
-  while (*ptr && *ptr != '}') {
-    ptr++;
+  // ====== finish ======
+  int min_arg_index = index;
+  int max_arg_index = index;
+  if (width_is_index) {
+    min_arg_index = min(min_arg_index, width_or_index);
+    max_arg_index = max(max_arg_index, width_or_index);
+  }
+  if (precision_is_index) {
+    min_arg_index = min(min_arg_index, precision_or_index);
+    max_arg_index = max(max_arg_index, precision_or_index);
+  }
+  if (min_arg_index < 0 || max_arg_index >= max_args) {
+    if (*format == '{')
+      goto error;
+
+    // skip the whole printf specifier
+    spec->valid = false;
+    return end - format;
   }
-  if (*ptr == 0)
-    goto early_exit;
 
-  // ====== finish ======
   spec->index = index;
   spec->flags = flags;
   spec->width_or_index = width_or_index;
@@ -222,159 +485,229 @@ parse_type:
   spec->precision_is_index = precision_is_index;
   spec->align = align;
   spec->fill_char = fill_char;
-  spec->type = start;
-  spec->type_len = ptr - start;
+  spec->type = type;
+  spec->type_len = ptr - type;
   spec->valid = true;
 
-  int max_arg_index = index;
-  if (width_is_index)
-    max_arg_index = max(max_arg_index, width_or_index);
-  if (precision_is_index)
-    max_arg_index = max(max_arg_index, precision_or_index);
-
   *arg_count = max(*arg_count, max_arg_index + 1);
   *arg_index = new_arg_index;
-  return ptr - format + 1;
+  return end - format;
 
   //
   // ERROR
-early_exit:
-  // something went wrong, write nothing and skip to end of format string
-  start = format;
-  while (*format && *format != '}') {
-    format++;
+error:
+  spec->valid = false;
+  if (*format == '%') {
+    // skip past the character that was not expected
+    return ptr - format + (*ptr ? 1 : 0);
   }
 
-  spec->valid = false;
-  return format - start + (*format == '}' ? 1 : 0);
-#undef CHECK_EOF
-#undef CHECK_MAX_ARGS
+  // write nothing and skip to end of the specifier
+  ptr = format;
+  while (*ptr && *ptr != '}') {
+    ptr++;
+  }
+  return ptr - format + (*ptr == '}' ? 1 : 0);
+}
+
+#undef T
+#undef T_ACTION
+#undef T_STATE
+
+// parses fmt '{...}' specifiers
+static inline size_t parse_fmt_spec(const char *format, int max_args, int *arg_index, int *arg_count, parsed_fmt_spec_t *spec) {
+  if (*format != '{') {
+    return 0;
+  }
+  return parse_spec(format, S_INDEX, max_args, arg_index, arg_count, spec);
 }
 
 // parses printf '%...' specifiers
 // TODO: maybe support positional arguments and dynamic width/precision
 static inline size_t parse_printf_spec(const char *format, int max_args, int *arg_index, int *arg_count, parsed_fmt_spec_t *spec) {
-#define CHECK_MAX_ARGS(idx) ({ \
-    if ((idx) >= max_args) {  \
-      goto early_exit;            \
-    }                             \
-  })
-#define CHECK_EOF(ptr) ({ \
-    if (*(ptr) == 0)      \
-      goto early_exit;    \
-  })
-
   if (*format != '%') {
     return 0;
   }
+  return parse_spec(format, S_P_FLAGS, max_args, arg_index, arg_count, spec);
+}
 
-  // %[flags][width][.precision]type
-  // ^ format
-  const char *end = format;
-  const char *ptr = format + 1;
-
-  int index;
-  int flags;
-  int width = 0;
-  int precision = 0;
-  fmt_align_t align = FMT_ALIGN_LEFT;
-  char fill_char = ' ';
-  int new_arg_index = *arg_index;
+//
 
-  CHECK_MAX_ARGS(new_arg_index);
-  index = new_arg_index;
-  new_arg_index++;
-
-  // ====== flags ======
-  CHECK_EOF(ptr);
-  flags = 0;
-parse_flags:
-  switch (*ptr) {
-    case '#': flags |= FMT_FLAG_ALT; ptr++;
-      goto parse_flags;
-    // '!' not in printf
-    case '0': flags |= FMT_FLAG_ZERO; fill_char = '0'; ptr++;
-      goto parse_flags;
-    case '+': flags |= FMT_FLAG_SIGN; ptr++;
-      goto parse_flags;
-    case '-': align = FMT_ALIGN_RIGHT; ptr++; // fake flag
-      flags &= ~FMT_FLAG_ZERO;
-      goto parse_flags;
-    case ' ': flags |= FMT_FLAG_SPACE; ptr++;
-      goto parse_flags;
-  }
-
-  // ====== width ======
-  CHECK_EOF(ptr);
-  if (is_digit(*ptr)) {
-    width = read_int(&ptr);
-  }
-
-  // ====== precision ======
-  CHECK_EOF(ptr);
-  if (*ptr == '.') {
-    ptr++;
-    if (is_digit(*ptr)) {
-      precision = read_int(&ptr);
-    } else {
-      goto early_exit;
+// loads the arguments [from, to) from the va_list according to their types.
+static inline void load_args(fmt_arg_t *args, int from, int to, va_list *va) {
+  for (int i = from; i < to; i++) {
+    switch (args[i].type) {
+      case FMT_ARGTYPE_NONE: args[i].value = fmt_rawvalue_uint64(0); break;
+      case FMT_ARGTYPE_INT32: args[i].value = fmt_rawvalue_uint64((uint64_t)va_arg(*va, int32_t)); break; // NOLINT(bugprone-branch-clone)
+      case FMT_ARGTYPE_INT64: args[i].value = fmt_rawvalue_uint64((uint64_t)va_arg(*va, int64_t)); break;
+      case FMT_ARGTYPE_DOUBLE: args[i].value = fmt_rawvalue_double(va_arg(*va, double)); break; // NOLINT(bugprone-branch-clone)
+      case FMT_ARGTYPE_FLOAT: args[i].value = fmt_rawvalue_double(va_arg(*va, double)); break;
+      case FMT_ARGTYPE_SIZE: args[i].value = fmt_rawvalue_uint64((uint64_t)va_arg(*va, size_t)); break;
+      case FMT_ARGTYPE_VOIDPTR: args[i].value = fmt_rawvalue_voidptr(va_arg(*va, void*)); break;
     }
+    args[i].argclass = FMT_ARGCLASS_NONE;
   }
+}
 
-  // we have built-in types like "lld" and "zx" which implicity encode the length
-  // in a backward compatible-way so we don't need to parse the length specifier
-  // separately.
+// fills in the static parts of a spec from the parsed specifier and resolves its type.
+// returns false if the type is unknown.
+static inline bool resolve_spec(const parsed_fmt_spec_t *parsed_spec, fmt_spec_t *spec) {
+  spec->type = parsed_spec->type;
+  spec->type_len = min(parsed_spec->type_len, FMTLIB_MAX_TYPE_LEN);
+  spec->value = fmt_rawvalue_uint64(0);
+  spec->flags = parsed_spec->flags;
+  spec->align = parsed_spec->align;
+  spec->fill_char = parsed_spec->fill_char;
+  spec->width = parsed_spec->width_is_index ? 0 : fmtlib_spec_int(parsed_spec->width_or_index);
+  spec->precision = parsed_spec->precision_is_index ? 0 : fmtlib_spec_int(parsed_spec->precision_or_index);
+  return fmtlib_resolve_type(spec);
+}
 
-  // ====== type ======
-  if (!fmtlib_parse_printf_type(ptr, &end)) {
-    ptr++;
-    end = ptr;
-    goto early_exit;
-  }
+// returns a buffer for writing the formatted string to. unlike fmtlib_buffer this does not
+// clear the memory up front, which for fmt_write means the whole remaining buffer on every
+// call. instead each entry point terminates the string once it is done with terminate().
+static inline fmt_buffer_t output_buffer(char *buffer, size_t size) {
+  return (fmt_buffer_t) {
+    .data = buffer,
+    .size = size - 1, // null terminator
+  };
+}
 
-  // ====== finish ======
-  spec->index = index;
-  spec->flags = flags;
-  spec->width_or_index = width;
-  spec->width_is_index = false;
-  spec->precision_or_index = precision;
-  spec->precision_is_index = false;
-  spec->align = align;
-  spec->fill_char = fill_char;
-  spec->type = ptr;
-  spec->type_len = end - ptr;
-  spec->valid = true;
+static inline size_t terminate(fmt_buffer_t *buf, size_t n) {
+  *buf->data = 0;
+  return n;
+}
 
-  int max_arg_index = index;
-  *arg_count = max(*arg_count, max_arg_index + 1);
-  *arg_index = new_arg_index;
-  return end - format;
+// writes the placeholder for a specifier with an unknown type.
+static size_t format_bad_type(fmt_buffer_t *buffer, const fmt_spec_t *spec) {
+  size_t n = 0;
+  n += fmtlib_buffer_write(buffer, "{bad type: ", 11);
+  n += fmtlib_buffer_write(buffer, spec->type, spec->type_len);
+  n += fmtlib_buffer_write_char(buffer, '}');
+  return n;
+}
 
-  //
-  // ERROR
-early_exit:
-  // something went wrong, bail out
-  spec->valid = false;
-  return end - format;
-#undef CHECK_EOF
-#undef CHECK_MAX_ARGS
+// returns whether a typed argument can be read as the given argument type. integers
+// of any width are stored as 64-bit values so they can be read by any integer type.
+static inline bool arg_matches(fmt_argtype_t argtype, fmt_argclass_t argclass) {
+  switch (argclass) {
+    case FMT_ARGCLASS_SIGNED:
+    case FMT_ARGCLASS_UNSIGNED:
+    case FMT_ARGCLASS_CHAR:
+      return argtype == FMT_ARGTYPE_INT32 || argtype == FMT_ARGTYPE_INT64 || argtype == FMT_ARGTYPE_SIZE;
+    case FMT_ARGCLASS_DOUBLE:
+    case FMT_ARGCLASS_FLOAT:
+      return argtype == FMT_ARGTYPE_DOUBLE || argtype == FMT_ARGTYPE_FLOAT;
+    case FMT_ARGCLASS_STRING:
+    case FMT_ARGCLASS_POINTER:
+      return argtype == FMT_ARGTYPE_VOIDPTR;
+    default:
+      return true; // unknown class
+  }
 }
 
-//
+// fetches an argument either from the array or from the provider
+static inline bool get_arg(const fmt_arg_t *args, fmt_arg_provider_t provider, void *ctx, int index, fmt_argtype_t argtype, fmt_raw_value_t *value) {
+  if (args != NULL) {
+    *value = args[index].value;
+    return true;
+  }
+  return provider(ctx, index, argtype, value);
+}
 
-size_t fmt_format(const char *format, char *buffer, size_t size, int max_args, va_list args) {
+// formats the string in a single pass starting with the given implicit argument index.
+// since the arguments can be accessed in any order there is no need for the two-pass
+// mode of fmt_format.
+static size_t format_typed(const char *format, fmt_buffer_t *buf, int max_args, int arg_index, const fmt_arg_t *args, fmt_arg_provider_t provider, void *ctx) {
+  size_t n = 0;
+  int arg_count = 0;
+  const char *ptr = format;
+  while (*ptr && !fmtlib_buffer_full(buf)) {
+    if (*ptr == '{' || *ptr == '%') {
+      char format_char = *ptr;
+      if (*(ptr + 1) == format_char) { // escaped
+        n += fmtlib_buffer_write_char(buf, *ptr);
+        ptr += 2;
+        continue;
+      }
+
+      parsed_fmt_spec_t parsed_spec;
+      fmt_spec_t spec = {0};
+      if (format_char == '{') {
+        ptr += parse_fmt_spec(ptr, max_args, &arg_index, &arg_count, &parsed_spec);
+      } else {
+        ptr += parse_printf_spec(ptr, max_args, &arg_index, &arg_count, &parsed_spec);
+      }
+      if (!parsed_spec.valid)
+        continue;
+
+      if (!resolve_spec(&parsed_spec, &spec)) {
+        if (format_char == '{') {
+          // invalid type
+          n += format_bad_type(buf, &spec);
+        }
+        continue;
+      }
+
+      if (spec.type_len == 0 && args != NULL) {
+        // the argument type is known so it picks the formatter
+        const fmt_arg_t *arg = &args[parsed_spec.index];
+        if (fmtlib_resolve_default(&spec, arg->argclass)) {
+          spec.argtype = arg->type;
+        }
+      } else if (spec.argtype != FMT_ARGTYPE_NONE && args != NULL) {
+        if (!arg_matches(spec.argtype, args[parsed_spec.index].argclass)) {
+          // the argument cannot be read as the type of the specifier
+          n += format_bad_type(buf, &spec);
+          continue;
+        }
+      }
+
+      fmt_raw_value_t value;
+      if (spec.argtype != FMT_ARGTYPE_NONE) {
+        if (!get_arg(args, provider, ctx, parsed_spec.index, spec.argtype, &spec.value))
+          continue;
+      }
+      if (parsed_spec.width_is_index) {
+        if (!get_arg(args, provider, ctx, parsed_spec.width_or_index, FMT_ARGTYPE_INT32, &value))
+          continue;
+        spec.width = fmtlib_spec_int((int) value.uint64_value);
+      }
+      if (parsed_spec.precision_is_index) {
+        if (!get_arg(args, provider, ctx, parsed_spec.precision_or_index, FMT_ARGTYPE_INT32, &value))
+          continue;
+        spec.precision = fmtlib_spec_int((int) value.uint64_value);
+      }
+
+      n += fmtlib_format_spec(buf, &spec);
+    } else if (*ptr == '}') {
+      n += fmtlib_buffer_write_char(buf, '}');
+      ptr++;
+      if (*ptr == '}')
+        ptr++; // skip extra to allow for balanced escaped braces
+    } else {
+      const char *end = scan_literal(ptr + 1);
+      n += fmtlib_buffer_write(buf, ptr, end - ptr);
+      ptr = end;
+    }
+  }
+  return n;
+}
+
+size_t fmt_format_scratch(const char *format, char *buffer, size_t size, fmt_arg_t *scratch, int max_args, va_list args) {
   va_list args_copy;
   va_copy(args_copy, args);
 
   size_t n = 0;
-  fmt_buffer_t buf = fmtlib_buffer(buffer, size);
+  fmt_buffer_t buf = output_buffer(buffer, size);
 
   // the formatter has two different modes of operation depending on the format string.
   // it always starts in single-pass mode, in which it writes to the buffer as it scans
   // the format string. the only time it switches to two-pass mode is when it encounters
   // a specifier that references an argument index greater than the number of arguments
   // read so far. in this case, we have to parse the rest of the format string to determine
-  // the size of each argument, load them, and then write it all to the buffer.
+  // the size of each argument, load them, and then parse it again from the specifier that
+  // caused the switch to write it all to the buffer.
   bool single_pass = true;
 
   // we keep three counters to track arguments. arg_index is used to track implicitly indexed
@@ -382,23 +715,19 @@ size_t fmt_format(const char *format, char *buffer, size_t size, int max_args, v
   // loaded_arg_count which tracks the number of arguments read with va_arg. the last counter
   // is only used in two-pass mode because in single-pass mode arg_index == loaded_arg_count.
   // these counters are passed to the specifier parser function, which will track them internally
-  // and then update the values through the pointers if the spec is valid.
+  // and then update the values through the pointers if the spec is valid. the types and values
+  // of the arguments are kept in the scratch array, which holds at least max_args entries.
   int arg_index = 0;
   int arg_count = 0;
   int loaded_arg_count = 0;
-  fmt_raw_value_t values[FMT_MAX_ARGS] = {0};
-  fmt_argtype_t argtypes[FMT_MAX_ARGS] = {0};
+  int typed_arg_count = 0;
 
-  // the following counter keeps track of specifiers when running in two-pass mode. in single-pass
-  // mode specifiers are written directly to the buffer and so there is no limit on the number of
-  // specifiers, as long as they dont reference more than FMT_MAX_ARGS arguments.
-  int spec_index = 0;
-  int pass_two_index;
-  fmt_spec_t specs[FMT_MAX_SPECS] = {0};
-  parsed_fmt_spec_t parsed_specs[FMT_MAX_SPECS] = {0};
+  // nothing is kept per specifier so there is no limit on the number of specifiers in
+  // either mode. the second pass only needs to know where to start parsing again.
+  const char *pass_two_start = NULL;
+  int pass_two_arg_index = 0;
 
   const char *ptr = format;
-  const char *pass_two_start;
   while (*ptr && !fmtlib_buffer_full(&buf)) {
     // start of fmt specifier
     if (*ptr == '{' || *ptr == '%') {
@@ -411,64 +740,48 @@ size_t fmt_format(const char *format, char *buffer, size_t size, int max_args, v
         continue;
       }
 
-      int cur_spec_index = spec_index;
-      if (cur_spec_index >= FMT_MAX_SPECS)
-        continue; // too many specifiers
-      spec_index++;
-
-      parsed_fmt_spec_t *parsed_spec = &parsed_specs[cur_spec_index];
-      fmt_spec_t *spec = &specs[cur_spec_index];
-      size_t m;
+      const char *spec_start = ptr;
+      int spec_arg_index = arg_index;
+      parsed_fmt_spec_t parsed_spec;
+      fmt_spec_t spec;
       if (format_char == '{') {
-        m = parse_fmt_spec(ptr, max_args, &arg_index, &arg_count, parsed_spec);
+        ptr += parse_fmt_spec(ptr, max_args, &arg_index, &arg_count, &parsed_spec);
       } else {
-        m = parse_printf_spec(ptr, max_args, &arg_index, &arg_count, parsed_spec);
-        // printf("parsed width: %d | is index: %d\n", parsed_spec->width_or_index, parsed_spec->width_is_index);
+        ptr += parse_printf_spec(ptr, max_args, &arg_index, &arg_count, &parsed_spec);
       }
-      spec->end = ptr + m;
-      ptr += m;
-      if (!parsed_spec->valid)
+      if (!parsed_spec.valid)
         continue;
 
+      // arguments have no type until a specifier references them
+      for (; typed_arg_count < arg_count; typed_arg_count++) {
+        scratch[typed_arg_count].type = FMT_ARGTYPE_NONE;
+      }
+
       if (single_pass && arg_count > arg_index + 1) {
         // the spec references an argument index greater than what we've loaded so far
         // so we have to switch to two-pass mode
         single_pass = false;
-        pass_two_start = ptr - m;
-        pass_two_index = cur_spec_index;
+        pass_two_start = spec_start;
+        pass_two_arg_index = spec_arg_index;
       }
 
-      memcpy(spec->type, parsed_spec->type, min(parsed_spec->type_len, FMTLIB_MAX_TYPE_LEN));
-      spec->type[parsed_spec->type_len] = 0;
-      spec->type_len = parsed_spec->type_len;
-      spec->value = fmt_rawvalue_uint64(0);
-      spec->flags = parsed_spec->flags;
-      spec->align = parsed_spec->align;
-      spec->fill_char = parsed_spec->fill_char;
-
       // resolve specifier type
-      if (!fmtlib_resolve_type(spec)) {
+      if (!resolve_spec(&parsed_spec, &spec)) {
         if (format_char == '{' && single_pass) {
           // invalid type
-          n += fmtlib_buffer_write(&buf, "{bad type: ", 11);
-          n += fmtlib_buffer_write(&buf, spec->type, parsed_spec->type_len);
-          n += fmtlib_buffer_write_char(&buf, '}');
+          n += format_bad_type(&buf, &spec);
         }
 
-        argtypes[parsed_spec->index] = FMT_ARGTYPE_NONE;
+        scratch[parsed_spec.index].type = FMT_ARGTYPE_NONE;
         continue;
       }
-      argtypes[parsed_spec->index] = spec->argtype;
+      scratch[parsed_spec.index].type = spec.argtype;
 
-      if (parsed_spec->width_is_index) {
-        argtypes[parsed_spec->width_or_index] = FMT_ARGTYPE_INT32;
-      } else {
-        spec->width = parsed_spec->width_or_index;
+      if (parsed_spec.width_is_index) {
+        scratch[parsed_spec.width_or_index].type = FMT_ARGTYPE_INT32;
       }
-      if (parsed_spec->precision_is_index) {
-        argtypes[parsed_spec->precision_or_index] = FMT_ARGTYPE_INT32;
-      } else {
-        spec->precision = parsed_spec->precision_or_index;
+      if (parsed_spec.precision_is_index) {
+        scratch[parsed_spec.precision_or_index].type = FMT_ARGTYPE_INT32;
       }
 
       if (!single_pass) {
@@ -477,35 +790,26 @@ size_t fmt_format(const char *format, char *buffer, size_t size, int max_args, v
 
       // =======================
       // SINGLE-PASS
-      if (spec->argtype == FMT_ARGTYPE_NONE) {
+      if (spec.argtype == FMT_ARGTYPE_NONE) {
         // no value
-        n += fmtlib_format_spec(&buf, spec);
+        n += fmtlib_format_spec(&buf, &spec);
         continue;
       }
 
       // load argument(s)
-      for (int i = loaded_arg_count; i < arg_count; i++) {
-        switch (argtypes[i]) {
-          case FMT_ARGTYPE_NONE: values[i] = fmt_rawvalue_uint64(0); break;
-          case FMT_ARGTYPE_INT32: values[i] = fmt_rawvalue_uint64((uint64_t)va_arg(args_copy, int32_t)); break; // NOLINT(bugprone-branch-clone)
-          case FMT_ARGTYPE_INT64: values[i] = fmt_rawvalue_uint64((uint64_t)va_arg(args_copy, int64_t)); break;
-          case FMT_ARGTYPE_DOUBLE: values[i] = fmt_rawvalue_double(va_arg(args_copy, double)); break;
-          case FMT_ARGTYPE_SIZE: values[i] = fmt_rawvalue_uint64((uint64_t)va_arg(args_copy, size_t)); break;
-          case FMT_ARGTYPE_VOIDPTR: values[i] = fmt_rawvalue_voidptr(va_arg(args_copy, void*)); break;
-        }
-        loaded_arg_count++;
-      }
+      load_args(scratch, loaded_arg_count, arg_count, &args_copy);
+      loaded_arg_count = arg_count;
 
-      spec->value = values[parsed_spec->index];
-      if (parsed_spec->width_is_index) {
-        spec->width = (int) values[parsed_spec->width_or_index].uint64_value;
+      spec.value = scratch[parsed_spec.index].value;
+      if (parsed_spec.width_is_index) {
+        spec.width = fmtlib_spec_int((int) scratch[parsed_spec.width_or_index].value.uint64_value);
       }
-      if (parsed_spec->precision_is_index) {
-        spec->precision = (int) values[parsed_spec->precision_or_index].uint64_value;
+      if (parsed_spec.precision_is_index) {
+        spec.precision = fmtlib_spec_int((int) scratch[parsed_spec.precision_or_index].value.uint64_value);
       }
 
       // format
-      n += fmtlib_format_spec(&buf, spec);
+      n += fmtlib_format_spec(&buf, &spec);
     } else if (*ptr == '}') {
       if (single_pass)
         n += fmtlib_buffer_write_char(&buf, '}');
@@ -514,84 +818,380 @@ size_t fmt_format(const char *format, char *buffer, size_t size, int max_args, v
       if (*ptr == '}')
         ptr++; // skip extra to allow for balanced escaped braces
     } else {
-        if (single_pass)
-          n += fmtlib_buffer_write_char(&buf, *ptr);
+      // write the whole run of literal characters at once
+      const char *end = scan_literal(ptr + 1);
+      if (single_pass)
+        n += fmtlib_buffer_write(&buf, ptr, end - ptr);
 
-        ptr++;
+      ptr = end;
     }
   }
 
-  if (single_pass)
-    return n;
+  if (single_pass) {
+    va_end(args_copy);
+    return terminate(&buf, n);
+  }
 
   // =======================
   // DOUBLE-PASS
 
   // load argument(s)
-  for (int i = loaded_arg_count; i < arg_count; i++) {
-    switch (argtypes[i]) {
-      case FMT_ARGTYPE_NONE: values[i] = fmt_rawvalue_uint64(0); break;
-      case FMT_ARGTYPE_INT32: values[i] = fmt_rawvalue_uint64((uint64_t)va_arg(args_copy, int32_t)); break; // NOLINT(bugprone-branch-clone)
-      case FMT_ARGTYPE_INT64: values[i] = fmt_rawvalue_uint64((uint64_t)va_arg(args_copy, int64_t)); break;
-      case FMT_ARGTYPE_DOUBLE: values[i] = fmt_rawvalue_double(va_arg(args_copy, double)); break;
-      case FMT_ARGTYPE_SIZE: values[i] = fmt_rawvalue_uint64((uint64_t)va_arg(args_copy, size_t)); break;
-      case FMT_ARGTYPE_VOIDPTR: values[i] = fmt_rawvalue_voidptr(va_arg(args_copy, void*)); break;
+  load_args(scratch, loaded_arg_count, arg_count, &args_copy);
+  va_end(args_copy);
+
+  // now make a second pass over the rest of the format string. all arguments are
+  // loaded so it can be formatted like an array of typed arguments.
+  n += format_typed(pass_two_start, &buf, max_args, pass_two_arg_index, scratch, NULL, NULL);
+  return terminate(&buf, n);
+}
+
+size_t fmt_format_nocache(const char *format, char *buffer, size_t size, int max_args, va_list args) {
+  fmt_arg_t scratch[FMT_MAX_ARGS];
+  return fmt_format_scratch(format, buffer, size, scratch, min(max_args, FMT_MAX_ARGS), args);
+}
+
+size_t fmt_write(fmt_buffer_t *buffer, const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  size_t n = fmt_format(format, buffer->data, buffer->size, FMT_MAX_ARGS, args);
+  va_end(args);
+
+  buffer->written += n;
+  buffer->data += n;
+  buffer->size -= n;
+  return n;
+}
+
+// MARK: Compiled formats
+
+// appends an op writing the literal [start, end) to the compiled program. returns
+// NULL if the program is out of ops.
+static inline fmt_op_t *push_op(fmt_compiled_t *compiled, const char *start, const char *end) {
+  if (compiled->num_ops >= compiled->max_ops)
+    return NULL;
+
+  fmt_op_t *op = &compiled->ops[compiled->num_ops++];
+  op->literal = start;
+  op->literal_len = end - start;
+  op->index = -1;
+  op->width_index = -1;
+  op->precision_index = -1;
+  return op;
+}
+
+// returns an upper bound of the output of a compiled program. the width and precision
+// taken from arguments can be anything that fits in a spec and specifiers without a
+// type may pick any formatter for a typed argument, so the latter are never bounded.
+static size_t compiled_max_len(const fmt_compiled_t *compiled) {
+  size_t max_len = 0;
+  for (int i = 0; i < compiled->num_ops; i++) {
+    const fmt_op_t *op = &compiled->ops[i];
+    size_t len = 0;
+    if (op->index >= 0) {
+      fmt_spec_t spec = op->spec;
+      if (spec.type_len == 0 || spec.formatter == format_bad_type) {
+        return SIZE_MAX;
+      }
+      if (op->width_index >= 0) {
+        spec.width = UINT16_MAX;
+      }
+      if (op->precision_index >= 0) {
+        spec.precision = UINT16_MAX;
+      }
+      len = fmtlib_spec_max_len(&spec);
     }
-    loaded_arg_count++;
+
+    if (len > SIZE_MAX - max_len - op->literal_len) {
+      return SIZE_MAX;
+    }
+    max_len += op->literal_len + len;
   }
+  return max_len;
+}
+
+int fmt_compile(const char *format, fmt_compiled_t *compiled, fmt_op_t *ops, int max_ops) {
+  compiled->format = format;
+  compiled->ops = ops;
+  compiled->num_ops = 0;
+  compiled->max_ops = max_ops;
+  compiled->arg_count = 0;
+  compiled->max_len = 0;
+  memset(compiled->argtypes, 0, sizeof(compiled->argtypes));
+
+  // the format string is scanned exactly like in fmt_format except that nothing is
+  // written. instead, every specifier becomes an op together with the literal text
+  // preceding it. escape sequences end the current literal span since the second
+  // character of the sequence has to be skipped.
+  int arg_index = 0;
+  const char *literal = format;
+  const char *ptr = format;
+  while (*ptr) {
+    if (*ptr == '{' || *ptr == '%') {
+      char format_char = *ptr;
+      if (*(ptr + 1) == format_char) { // escaped
+        if (!push_op(compiled, literal, ptr + 1))
+          return -1;
 
-  // now make a second pass over the format string to print it. this time we dont
-  // have to reparse the specifiers
-  ptr = pass_two_start;
-  int index = pass_two_index;
-  while (*ptr && !fmtlib_buffer_full(&buf) && index < spec_index) {
-    if (*ptr == '{') {
-      if (*(ptr + 1) == '{') { // escaped
-        n += fmtlib_buffer_write_char(&buf, '{');
         ptr += 2;
+        literal = ptr;
         continue;
       }
 
-      parsed_fmt_spec_t *parsed_spec = &parsed_specs[index];
-      fmt_spec_t *spec = &specs[index];
-      index++;
-      if (!parsed_spec->valid)
+      parsed_fmt_spec_t parsed_spec;
+      size_t m;
+      if (format_char == '{') {
+        m = parse_fmt_spec(ptr, FMT_MAX_ARGS, &arg_index, &compiled->arg_count, &parsed_spec);
+      } else {
+        m = parse_printf_spec(ptr, FMT_MAX_ARGS, &arg_index, &compiled->arg_count, &parsed_spec);
+      }
+
+      fmt_op_t *op = push_op(compiled, literal, ptr);
+      if (!op)
+        return -1;
+
+      ptr += m;
+      literal = ptr;
+      if (!parsed_spec.valid)
+        continue;
+
+      memset(&op->spec, 0, sizeof(fmt_spec_t));
+      if (!resolve_spec(&parsed_spec, &op->spec)) {
+        compiled->argtypes[parsed_spec.index] = FMT_ARGTYPE_NONE;
+        if (format_char == '{') {
+          // invalid type
+          op->index = parsed_spec.index;
+          op->spec.formatter = format_bad_type;
+          op->spec.width = 0;
+        }
         continue;
+      }
 
-      spec->value = values[parsed_spec->index];
-      if (parsed_spec->width_is_index) {
-        spec->width = (int) values[parsed_spec->width_or_index].uint64_value;
+      op->index = parsed_spec.index;
+      compiled->argtypes[parsed_spec.index] = op->spec.argtype;
+      if (parsed_spec.width_is_index) {
+        op->width_index = parsed_spec.width_or_index;
+        compiled->argtypes[parsed_spec.width_or_index] = FMT_ARGTYPE_INT32;
       }
-      if (parsed_spec->precision_is_index) {
-        spec->precision = (int) values[parsed_spec->precision_or_index].uint64_value;
+      if (parsed_spec.precision_is_index) {
+        op->precision_index = parsed_spec.precision_or_index;
+        compiled->argtypes[parsed_spec.precision_or_index] = FMT_ARGTYPE_INT32;
       }
-
-      n += fmtlib_format_spec(&buf, spec);
-      ptr = spec->end;
     } else if (*ptr == '}') {
-      n += fmtlib_buffer_write_char(&buf, '}');
       ptr++;
-      if (*ptr == '}')
+      if (*ptr == '}') {
+        // skip extra to allow for balanced escaped braces
+        if (!push_op(compiled, literal, ptr))
+          return -1;
+
         ptr++;
+        literal = ptr;
+      }
     } else {
-      n += fmtlib_buffer_write_char(&buf, *ptr);
-      ptr++;
+      ptr = scan_literal(ptr + 1);
     }
   }
 
-  while (*ptr && !fmtlib_buffer_full(&buf)) {
-    n += fmtlib_buffer_write_char(&buf, *ptr);
-    ptr++;
+  if (ptr > literal && !push_op(compiled, literal, ptr))
+    return -1;
+
+  compiled->max_len = compiled_max_len(compiled);
+  return compiled->num_ops;
+}
+
+// runs the ops of a compiled program with the loaded arguments. arguments with a
+// class pick the formatter of specifiers without a type and are checked against the
+// type of the others.
+static inline size_t run_compiled(const fmt_compiled_t *compiled, fmt_buffer_t *buf, const fmt_arg_t *args, int num_args) {
+  // when the whole output is known to fit, integers are written without bounds checks
+  bool unchecked = compiled->max_len <= buf->size;
+  size_t n = 0;
+  for (int i = 0; i < compiled->num_ops && !fmtlib_buffer_full(buf); i++) {
+    const fmt_op_t *op = &compiled->ops[i];
+    n += fmtlib_buffer_write(buf, op->literal, op->literal_len);
+    if (op->index < 0)
+      continue;
+
+    fmt_spec_t spec = op->spec;
+    if (op->index < num_args) {
+      if (spec.type_len == 0) {
+        fmtlib_resolve_default(&spec, args[op->index].argclass);
+      } else if (spec.argtype != FMT_ARGTYPE_NONE && !arg_matches(spec.argtype, args[op->index].argclass)) {
+        n += format_bad_type(buf, &spec);
+        continue;
+      }
+      spec.value = args[op->index].value;
+    }
+    if (op->width_index >= 0) {
+      spec.width = op->width_index < num_args ? fmtlib_spec_int((int) args[op->width_index].value.uint64_value) : 0;
+    }
+    if (op->precision_index >= 0) {
+      spec.precision = op->precision_index < num_args ? fmtlib_spec_int((int) args[op->precision_index].value.uint64_value) : 0;
+    }
+
+    n += unchecked ? fmtlib_format_spec_unchecked(buf, &spec) : fmtlib_format_spec(buf, &spec);
   }
+  return n;
+}
+
+size_t fmt_format_compiled(const fmt_compiled_t *compiled, char *buffer, size_t size, va_list args) {
+  va_list args_copy;
+  va_copy(args_copy, args);
 
+  // all argument types are known up front so the arguments are loaded in one go
+  // and the ops can reference them in any order.
+  fmt_arg_t loaded[FMT_MAX_ARGS];
+  for (int i = 0; i < compiled->arg_count; i++) {
+    loaded[i].type = compiled->argtypes[i];
+  }
+  load_args(loaded, 0, compiled->arg_count, &args_copy);
   va_end(args_copy);
+
+  fmt_buffer_t buf = output_buffer(buffer, size);
+  return terminate(&buf, run_compiled(compiled, &buf, loaded, compiled->arg_count));
+}
+
+size_t fmt_format_compiled_args(const fmt_compiled_t *compiled, char *buffer, size_t size, const fmt_arg_t *args, int num_args) {
+  fmt_buffer_t buf = output_buffer(buffer, size);
+  return terminate(&buf, run_compiled(compiled, &buf, args, num_args));
+}
+
+size_t fmt_write_compiled(fmt_buffer_t *buffer, const fmt_compiled_t *compiled, ...) {
+  va_list args;
+  va_start(args, compiled);
+  size_t n = fmt_format_compiled(compiled, buffer->data, buffer->size, args);
+  va_end(args);
+
+  buffer->written += n;
+  buffer->data += n;
+  buffer->size -= n;
   return n;
 }
 
-size_t fmt_write(fmt_buffer_t *buffer, const char *format, ...) {
+// MARK: Typed arguments
+
+size_t fmt_format_args(const char *format, char *buffer, size_t size, const fmt_arg_t *args, int num_args) {
+  fmt_buffer_t buf = output_buffer(buffer, size);
+  return terminate(&buf, format_typed(format, &buf, num_args, 0, args, NULL, NULL));
+}
+
+size_t fmt_format_provider(const char *format, char *buffer, size_t size, int max_args, fmt_arg_provider_t provider, void *ctx) {
+  fmt_buffer_t buf = output_buffer(buffer, size);
+  return terminate(&buf, format_typed(format, &buf, max_args, 0, NULL, provider, ctx));
+}
+
+size_t fmt_write_args(fmt_buffer_t *buffer, const char *format, const fmt_arg_t *args, int num_args) {
+  size_t n = fmt_format_args(format, buffer->data, buffer->size, args, num_args);
+  buffer->written += n;
+  buffer->data += n;
+  buffer->size -= n;
+  return n;
+}
+
+// MARK: Format cache
+
+// the number of slots probed when looking up or inserting a format
+#define FMT_CACHE_PROBES 4
+
+static fmt_cache_t *installed_cache;
+
+// returns the first slot of the probe sequence for the format pointer
+static inline int cache_slot(const fmt_cache_t *cache, const char *format) {
+  uint64_t hash = ((uintptr_t) format >> 3) * 0x9E3779B97F4A7C15ull;
+  return (int) (((hash >> 32) * (uint64_t) cache->num_entries) >> 32);
+}
+
+// looks up the format in the cache. entries are immutable once their key has been
+// published so readers only need an acquire load of the key.
+static inline const fmt_cache_entry_t *cache_lookup(fmt_cache_t *cache, const char *format) {
+  int slot = cache_slot(cache, format);
+  for (int i = 0; i < FMT_CACHE_PROBES && i < cache->num_entries; i++) {
+    const fmt_cache_entry_t *entry = &cache->entries[(slot + i) % cache->num_entries];
+    const char *key = __atomic_load_n(&entry->format, __ATOMIC_ACQUIRE);
+    if (key == format)
+      return entry;
+    if (key == NULL)
+      break;
+  }
+  return NULL;
+}
+
+// compiles the format into a free slot of the cache. inserts are serialized by a
+// try-lock, if another thread is inserting the format is simply not cached this time.
+static inline const fmt_cache_entry_t *cache_insert(fmt_cache_t *cache, const char *format) {
+  if (__atomic_exchange_n(&cache->lock, 1, __ATOMIC_ACQUIRE))
+    return NULL;
+
+  fmt_cache_entry_t *result = NULL;
+  int slot = cache_slot(cache, format);
+  for (int i = 0; i < FMT_CACHE_PROBES && i < cache->num_entries; i++) {
+    fmt_cache_entry_t *entry = &cache->entries[(slot + i) % cache->num_entries];
+    const char *key = __atomic_load_n(&entry->format, __ATOMIC_RELAXED);
+    if (key == format) {
+      // inserted by another thread in the meantime
+      result = entry;
+      break;
+    } else if (key != NULL) {
+      continue;
+    }
+
+    // formats which do not fit into the remaining ops are still published so
+    // that later calls go straight to the uncached formatter.
+    int num_ops = fmt_compile(format, &entry->compiled, cache->ops + cache->used_ops, cache->max_ops - cache->used_ops);
+    if (num_ops < 0) {
+      entry->compiled.num_ops = -1;
+    } else {
+      cache->used_ops += num_ops;
+    }
+
+    __atomic_store_n(&entry->format, format, __ATOMIC_RELEASE);
+    result = entry;
+    break;
+  }
+
+  __atomic_store_n(&cache->lock, 0, __ATOMIC_RELEASE);
+  return result;
+}
+
+void fmt_cache_init(fmt_cache_t *cache, fmt_cache_entry_t *entries, int num_entries, fmt_op_t *ops, int max_ops) {
+  memset(entries, 0, num_entries * sizeof(fmt_cache_entry_t));
+  cache->entries = entries;
+  cache->num_entries = num_entries;
+  cache->ops = ops;
+  cache->max_ops = max_ops;
+  cache->used_ops = 0;
+  cache->lock = 0;
+  cache->hits = 0;
+  cache->misses = 0;
+}
+
+void fmt_cache_install(fmt_cache_t *cache) {
+  __atomic_store_n(&installed_cache, cache, __ATOMIC_RELEASE);
+}
+
+size_t fmt_format(const char *format, char *buffer, size_t size, int max_args, va_list args) {
+  fmt_cache_t *cache = __atomic_load_n(&installed_cache, __ATOMIC_ACQUIRE);
+  if (cache == NULL || cache->num_entries == 0 || max_args < FMT_MAX_ARGS) {
+    return fmt_format_nocache(format, buffer, size, max_args, args);
+  }
+
+  const fmt_cache_entry_t *entry = cache_lookup(cache, format);
+  if (entry != NULL) {
+    __atomic_fetch_add(&cache->hits, 1, __ATOMIC_RELAXED);
+  } else {
+    __atomic_fetch_add(&cache->misses, 1, __ATOMIC_RELAXED);
+    entry = cache_insert(cache, format);
+  }
+
+  if (entry == NULL || entry->compiled.num_ops < 0) {
+    return fmt_format_nocache(format, buffer, size, max_args, args);
+  }
+  return fmt_format_compiled(&entry->compiled, buffer, size, args);
+}
+
+size_t fmt_write_nocache(fmt_buffer_t *buffer, const char *format, ...) {
   va_list args;
   va_start(args, format);
-  size_t n = fmt_format(format, buffer->data, buffer->size, FMT_MAX_ARGS, args);
+  size_t n = fmt_format_nocache(format, buffer->data, buffer->size, FMT_MAX_ARGS, args);
   va_end(args);
 
   buffer->written += n;
@@ -600,4 +1200,99 @@ size_t fmt_write(fmt_buffer_t *buffer, const char *format, ...) {
   return n;
 }
 
+// MARK: Call-site formats
+
+#define CALLSITE_EMPTY     0
+#define CALLSITE_COMPILING 1
+#define CALLSITE_READY     2
+#define CALLSITE_FALLBACK  3 // format does not fit into the call site
+
+size_t fmt_write_callsite(fmt_buffer_t *buffer, fmt_callsite_t *site, const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+
+  int state = __atomic_load_n(&site->state, __ATOMIC_ACQUIRE);
+  if (state == CALLSITE_EMPTY) {
+    // the first thread to get here compiles the format, all others format it
+    // uncompiled until the compiled format is published.
+    int expected = CALLSITE_EMPTY;
+    if (__atomic_compare_exchange_n(&site->state, &expected, CALLSITE_COMPILING, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+      if (fmt_compile(format, &site->compiled, site->ops, FMT_CALLSITE_MAX_OPS) < 0) {
+        state = CALLSITE_FALLBACK;
+      } else {
+        state = CALLSITE_READY;
+      }
+      __atomic_store_n(&site->state, state, __ATOMIC_RELEASE);
+    }
+  }
+
+  size_t n;
+  if (state == CALLSITE_READY) {
+    n = fmt_format_compiled(&site->compiled, buffer->data, buffer->size, args);
+  } else {
+    n = fmt_format(format, buffer->data, buffer->size, FMT_MAX_ARGS, args);
+  }
+  va_end(args);
+
+  buffer->written += n;
+  buffer->data += n;
+  buffer->size -= n;
+  return n;
+}
+
+// MARK: Arrays
+
+// reads an element of an array the same way an argument of the type is read.
+static inline fmt_raw_value_t load_element(const void *values, size_t i, fmt_argtype_t argtype) {
+  switch (argtype) {
+    case FMT_ARGTYPE_INT32: return fmt_rawvalue_uint64((uint64_t) ((const int32_t *) values)[i]);
+    case FMT_ARGTYPE_INT64: return fmt_rawvalue_uint64((uint64_t) ((const int64_t *) values)[i]);
+    case FMT_ARGTYPE_DOUBLE: return fmt_rawvalue_double(((const double *) values)[i]);
+    case FMT_ARGTYPE_FLOAT: return fmt_rawvalue_double(((const float *) values)[i]);
+    case FMT_ARGTYPE_SIZE: return fmt_rawvalue_uint64((uint64_t) ((const size_t *) values)[i]);
+    case FMT_ARGTYPE_VOIDPTR: return fmt_rawvalue_voidptr(((void *const *) values)[i]);
+    default: return fmt_rawvalue_uint64(0);
+  }
+}
+
+size_t fmt_write_array(fmt_buffer_t *buffer, const char *format, const void *values, size_t count, const char *separator) {
+  fmt_op_t ops[FMT_ARRAY_MAX_OPS];
+  fmt_compiled_t compiled;
+  if (fmt_compile(format, &compiled, ops, FMT_ARRAY_MAX_OPS) < 0 || compiled.arg_count != 1) {
+    return 0;
+  }
+
+  fmt_argtype_t argtype = compiled.argtypes[0];
+  if (argtype == FMT_ARGTYPE_NONE) {
+    return 0;
+  }
+
+  size_t separator_len = 0;
+  while (separator[separator_len]) {
+    separator_len++;
+  }
+
+  // a format which is just the specifier may be handled by the batch path, all
+  // others run the compiled format once per element.
+  fmt_buffer_t buf = output_buffer(buffer->data, buffer->size);
+  size_t n;
+  if (compiled.num_ops != 1 || ops[0].literal_len != 0 ||
+      !fmtlib_format_array(&buf, &ops[0].spec, values, count, separator, separator_len, &n)) {
+    n = 0;
+    for (size_t i = 0; i < count && !fmtlib_buffer_full(&buf); i++) {
+      if (i > 0) {
+        n += fmtlib_buffer_write(&buf, separator, separator_len);
+      }
+      fmt_arg_t arg = { argtype, FMT_ARGCLASS_NONE, load_element(values, i, argtype) };
+      n += run_compiled(&compiled, &buf, &arg, 1);
+    }
+  }
+  terminate(&buf, n);
+
+  buffer->written += n;
+  buffer->data += n;
+  buffer->size -= n;
+  return n;
+}
+
 #pragma clang diagnostic pop
@@ -15,14 +15,36 @@
 
 // determines the maximum number of arguments that can be passed to fmt_format.
 // extra arguments are ignored. the `max_args` parameter to fmt_format is clamped
-// to this value.
+// to this value. fmt_format_scratch can be used to format more arguments.
 #define FMT_MAX_ARGS 10
 
-// determines the maximum number of format specifiers that can be used in a single
-// format string. note that the formatting is still limited by FMT_MAX_ARGS but as
-// long as specifiers do not implicitly consume arguments beyond this, they are
-// allowed up to this limit.
-#define FMT_MAX_SPECS 30
+// determines the number of ops reserved for each fmt_write_static call site. call
+// sites with formats that need more ops are formatted by fmt_format instead.
+#ifndef FMT_CALLSITE_MAX_OPS
+#define FMT_CALLSITE_MAX_OPS 8
+#endif
+
+// determines the number of ops available to the element format of fmt_write_array.
+#ifndef FMT_ARRAY_MAX_OPS
+#define FMT_ARRAY_MAX_OPS 8
+#endif
+
+/// A value tagged with its argument type and class.
+typedef struct fmt_arg {
+  fmt_argtype_t type;
+  fmt_argclass_t argclass;
+  fmt_raw_value_t value;
+} fmt_arg_t;
+#define fmt_arg_int32(v) ((fmt_arg_t) { FMT_ARGTYPE_INT32, FMT_ARGCLASS_SIGNED, fmt_rawvalue_uint64((uint64_t)(int32_t)(v)) })
+#define fmt_arg_uint32(v) ((fmt_arg_t) { FMT_ARGTYPE_INT32, FMT_ARGCLASS_UNSIGNED, fmt_rawvalue_uint64((uint64_t)(uint32_t)(v)) })
+#define fmt_arg_int64(v) ((fmt_arg_t) { FMT_ARGTYPE_INT64, FMT_ARGCLASS_SIGNED, fmt_rawvalue_uint64((uint64_t)(int64_t)(v)) })
+#define fmt_arg_uint64(v) ((fmt_arg_t) { FMT_ARGTYPE_INT64, FMT_ARGCLASS_UNSIGNED, fmt_rawvalue_uint64((uint64_t)(v)) })
+#define fmt_arg_double(v) ((fmt_arg_t) { FMT_ARGTYPE_DOUBLE, FMT_ARGCLASS_DOUBLE, fmt_rawvalue_double(v) })
+#define fmt_arg_float(v) ((fmt_arg_t) { FMT_ARGTYPE_FLOAT, FMT_ARGCLASS_FLOAT, fmt_rawvalue_double((float)(v)) })
+#define fmt_arg_size(v) ((fmt_arg_t) { FMT_ARGTYPE_SIZE, FMT_ARGCLASS_UNSIGNED, fmt_rawvalue_uint64((uint64_t)(size_t)(v)) })
+#define fmt_arg_char(v) ((fmt_arg_t) { FMT_ARGTYPE_INT32, FMT_ARGCLASS_CHAR, fmt_rawvalue_uint64((uint64_t)(unsigned char)(v)) })
+#define fmt_arg_string(v) ((fmt_arg_t) { FMT_ARGTYPE_VOIDPTR, FMT_ARGCLASS_STRING, fmt_rawvalue_voidptr((void *)(v)) })
+#define fmt_arg_voidptr(v) ((fmt_arg_t) { FMT_ARGTYPE_VOIDPTR, FMT_ARGCLASS_POINTER, fmt_rawvalue_voidptr((void *)(v)) })
 
 
 // -----------------------------------------------------------------------------
@@ -82,13 +104,23 @@
  *     use the specified argument as the width. When using the '*' syntax, the argument must
  *     be an integer.
  *
+ *     Widths above 65535 are limited to 65535 and negative widths are ignored, the same
+ *     applies to the precision. Otherwise the width is only limited by the destination buffer.
+ *
  * precision
  *     The precision field is an optional positive integer.
  *     For floating point numbers, it specifies the number of digits to display after the
- *     decimal point. The default precision is 6 and the maximum precision is 9. The output
- *     is padded with trailing zeros if necessary.
+ *     decimal point. The default precision is 6. The digits are exact and correctly rounded
+ *     for any precision and magnitude, so 1e25 is displayed as 10000000000000000905969664.
+ *     For 'e' it is the number of digits after the decimal point of the mantissa. The 'g'
+ *     type prints the shortest digits which read back as the same double, unless a precision
+ *     is given, in which case it is the number of significant digits like printf %g. The
+ *     printf '%g' defaults to a precision of 6. For 'a' it is the number of hex digits after
+ *     the point, by default all digits up to the last nonzero one are displayed.
  *     For integers, it specifies the minimum number of digits to display. By default, there
  *     is no minimum number of digits. The output is padded with leading zeros if necessary.
+ *     For fixed-point integers, it specifies the decimal scale of the value, so 1234 with a
+ *     precision of 2 is displayed as 12.34. The conversion is exact for any precision.
  *     For strings, it specifies the maximum number of characters to display. By default,
  *     strings are read until the first null character is found, but the precision field can
  *     be used to limit the number of characters read.
@@ -106,18 +138,33 @@
  *         '[<type>]b'   - unsigned binary integer
  *         '[<type>]o'   - unsigned octal integer
  *         '[<type>]x'   - unsigned hexadecimal integer
+ *         '[<type>]r<n>' - unsigned integer in base n (2-62), 'R' swaps the letter case
+ *         '[<type>]k'   - signed fixed-point integer scaled by the precision
  *         where <type> is one of the following:
  *           'll' - 64-bit integer
  *           'z'  - size_t
+ *           'w128' - 128-bit integer, passed as a pointer to the value
  *         or a 32-bit integer if no type is specified
  *
  *
  *         'f'             - floating point number (double)
  *         'F'             - floating point number capitalized
+ *         'g'             - shortest round-trip floating point number (double)
+ *         'G'             - shortest round-trip floating point number capitalized
+ *         'e'             - floating point number in scientific notation (double)
+ *         'E'             - floating point number in scientific notation capitalized
+ *         'a'             - floating point number in hexadecimal notation (e.g. 0x1.8p+1)
+ *         'A'             - floating point number in hexadecimal notation capitalized
+ *         where an 'h' in front of the type (e.g. 'hg') selects a float argument. Floats
+ *         are passed as doubles, but 'hg' writes the shortest digits of the float.
  *
  *         's'             - string
  *         'c'             - character
  *         'p'             - pointer
+ *         'N'             - big integer, passed as a pointer to a fmt_bigint_t.
+ *                           Values above FMTLIB_BIGINT_MAX_LIMBS limbs (2048 bits by default) need
+ *                           FMTLIB_BIGINT_SCRATCH_LIMBS(count) scratch limbs in the fmt_bigint_t,
+ *                           otherwise "{bigint too large}" is written.
  *
  * Notes:
  *
@@ -130,6 +177,7 @@
  *     {:d}      - integer
  *     {:05d}    - integer, sign-aware zero padding
  *     {:.2f}    - double, 2 decimal places
+ *     {:.6llk}  - 64-bit integer in millionths, 6 decimal places
  *     {:>10u}   - unsigned, right justified with spaces
  *     {:$#^10d} - integer, center justified with '#'
  *     {:s}      - string
@@ -138,6 +186,28 @@
  */
 size_t fmt_format(const char *format, char *buffer, size_t size, int max_args, va_list args);
 
+/**
+ * Formats a string like fmt_format using caller-provided scratch space for the
+ * arguments. The number of arguments is only limited by the size of the scratch
+ * space and there is no limit on the number of specifiers.
+ *
+ * @param format the format string
+ * @param buffer the buffer to write to
+ * @param size the size of the buffer
+ * @param scratch the scratch space for the arguments
+ * @param max_args the number of arguments in the scratch space
+ * @param args the arguments
+ * @return the number of bytes written to the buffer
+ */
+size_t fmt_format_scratch(const char *format, char *buffer, size_t size, fmt_arg_t *scratch, int max_args, va_list args);
+
+/**
+ * Formats a string like fmt_format but never consults the installed format cache.
+ * This should be used for format strings built at runtime whose address may be
+ * reused for different contents.
+ */
+size_t fmt_format_nocache(const char *format, char *buffer, size_t size, int max_args, va_list args);
+
 /**
  * Writes a formatted string to the given fmt_buffer.
  *
@@ -148,4 +218,326 @@ size_t fmt_format(const char *format, char *buffer, size_t size, int max_args, v
  */
 size_t fmt_write(fmt_buffer_t *buffer, const char *format, ...);
 
+/**
+ * Writes a formatted string to the given fmt_buffer without consulting the
+ * installed format cache.
+ *
+ * @param buffer the buffer to write to
+ * @param format the format string
+ * @param ...
+ * @return the number of bytes written to the buffer
+ */
+size_t fmt_write_nocache(fmt_buffer_t *buffer, const char *format, ...);
+
+// MARK: Typed arguments
+// =====================
+// Instead of a va_list, the arguments can be passed as an array of values tagged with
+// their type, or fetched on demand from a provider callback. Both allow random access
+// to the arguments so positional indices never force a second pass over the format.
+
+/// A function which provides the argument at the given index. The argtype is the type
+/// expected by the specifier. Returns false if there is no such argument, in which case
+/// the specifier is skipped.
+typedef bool (*fmt_arg_provider_t)(void *ctx, int index, fmt_argtype_t argtype, fmt_raw_value_t *value);
+
+/**
+ * Formats a string like fmt_format with the arguments taken from an array.
+ * Specifiers without a type use the default formatter for the argument class.
+ *
+ * @param format the format string
+ * @param buffer the buffer to write to
+ * @param size the size of the buffer
+ * @param args the arguments
+ * @param num_args the number of arguments
+ * @return the number of bytes written to the buffer
+ */
+size_t fmt_format_args(const char *format, char *buffer, size_t size, const fmt_arg_t *args, int num_args);
+
+/**
+ * Formats a string like fmt_format with the arguments fetched from a provider.
+ *
+ * @param format the format string
+ * @param buffer the buffer to write to
+ * @param size the size of the buffer
+ * @param max_args the number of arguments the provider may be asked for
+ * @param provider the argument provider
+ * @param ctx the context passed to the provider
+ * @return the number of bytes written to the buffer
+ */
+size_t fmt_format_provider(const char *format, char *buffer, size_t size, int max_args, fmt_arg_provider_t provider, void *ctx);
+
+/**
+ * Writes a formatted string to the given fmt_buffer with the arguments taken from an array.
+ *
+ * @param buffer the buffer to write to
+ * @param format the format string
+ * @param args the arguments
+ * @param num_args the number of arguments
+ * @return the number of bytes written to the buffer
+ */
+size_t fmt_write_args(fmt_buffer_t *buffer, const char *format, const fmt_arg_t *args, int num_args);
+
+// MARK: Generic arguments
+// =======================
+// With C11, fmt_write_typed infers the type of each argument at compile time and
+// passes them to fmt_write_args as typed arguments. Since the type of each value is
+// known, specifiers may omit the type (e.g. "{}" or "{:>8}"). A specifier whose type
+// cannot read its argument (e.g. "{:s}" with an int or "{:f}" with a pointer) writes
+// "{bad type: ...}" instead of misreading it. Integers of any width are interchangeable.
+//
+//   fmt_write_typed(&buffer, "{} took {:.2f} ms", name, elapsed);
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+
+static inline fmt_arg_t fmt_arg_signed_(long long v) { return fmt_arg_int64(v); }
+static inline fmt_arg_t fmt_arg_unsigned_(unsigned long long v) { return fmt_arg_uint64(v); }
+static inline fmt_arg_t fmt_arg_double_(double v) { return fmt_arg_double(v); }
+static inline fmt_arg_t fmt_arg_float_(float v) { return fmt_arg_float(v); }
+static inline fmt_arg_t fmt_arg_char_(char v) { return fmt_arg_char(v); }
+static inline fmt_arg_t fmt_arg_string_(const char *v) { return fmt_arg_string(v); }
+static inline fmt_arg_t fmt_arg_pointer_(const void *v) { return fmt_arg_voidptr(v); }
+
+/// Packs a value together with its static type into a typed argument.
+#define fmt_arg(v) _Generic((v), \
+  _Bool: fmt_arg_unsigned_, \
+  char: fmt_arg_char_, \
+  signed char: fmt_arg_signed_, \
+  short: fmt_arg_signed_, \
+  int: fmt_arg_signed_, \
+  long: fmt_arg_signed_, \
+  long long: fmt_arg_signed_, \
+  unsigned char: fmt_arg_unsigned_, \
+  unsigned short: fmt_arg_unsigned_, \
+  unsigned int: fmt_arg_unsigned_, \
+  unsigned long: fmt_arg_unsigned_, \
+  unsigned long long: fmt_arg_unsigned_, \
+  float: fmt_arg_float_, \
+  double: fmt_arg_double_, \
+  char *: fmt_arg_string_, \
+  const char *: fmt_arg_string_, \
+  default: fmt_arg_pointer_)(v)
+
+// counts the arguments after the format (up to 16)
+#define FMT_NARGS(...) FMT_NARGS_(__VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define FMT_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, n, ...) n
+#define FMT_FORMAT(...) FMT_FORMAT_(__VA_ARGS__, 0)
+#define FMT_FORMAT_(f, ...) f
+#define FMT_CAT(a, b) FMT_CAT_(a, b)
+#define FMT_CAT_(a, b) a##b
+
+// expands to the typed arguments after the format
+#define FMT_ARGS_0(f) {0}
+#define FMT_ARGS_1(f, a) fmt_arg(a)
+#define FMT_ARGS_2(f, a, ...) fmt_arg(a), FMT_ARGS_1(f, __VA_ARGS__)
+#define FMT_ARGS_3(f, a, ...) fmt_arg(a), FMT_ARGS_2(f, __VA_ARGS__)
+#define FMT_ARGS_4(f, a, ...) fmt_arg(a), FMT_ARGS_3(f, __VA_ARGS__)
+#define FMT_ARGS_5(f, a, ...) fmt_arg(a), FMT_ARGS_4(f, __VA_ARGS__)
+#define FMT_ARGS_6(f, a, ...) fmt_arg(a), FMT_ARGS_5(f, __VA_ARGS__)
+#define FMT_ARGS_7(f, a, ...) fmt_arg(a), FMT_ARGS_6(f, __VA_ARGS__)
+#define FMT_ARGS_8(f, a, ...) fmt_arg(a), FMT_ARGS_7(f, __VA_ARGS__)
+#define FMT_ARGS_9(f, a, ...) fmt_arg(a), FMT_ARGS_8(f, __VA_ARGS__)
+#define FMT_ARGS_10(f, a, ...) fmt_arg(a), FMT_ARGS_9(f, __VA_ARGS__)
+#define FMT_ARGS_11(f, a, ...) fmt_arg(a), FMT_ARGS_10(f, __VA_ARGS__)
+#define FMT_ARGS_12(f, a, ...) fmt_arg(a), FMT_ARGS_11(f, __VA_ARGS__)
+#define FMT_ARGS_13(f, a, ...) fmt_arg(a), FMT_ARGS_12(f, __VA_ARGS__)
+#define FMT_ARGS_14(f, a, ...) fmt_arg(a), FMT_ARGS_13(f, __VA_ARGS__)
+#define FMT_ARGS_15(f, a, ...) fmt_arg(a), FMT_ARGS_14(f, __VA_ARGS__)
+#define FMT_ARGS_16(f, a, ...) fmt_arg(a), FMT_ARGS_15(f, __VA_ARGS__)
+
+/// Writes a formatted string to the given fmt_buffer with the argument types inferred
+/// at compile time: fmt_write_typed(buffer, format, ...)
+#define fmt_write_typed(buffer, ...) \
+  fmt_write_args(buffer, FMT_FORMAT(__VA_ARGS__), \
+                 (fmt_arg_t[]) { FMT_CAT(FMT_ARGS_, FMT_NARGS(__VA_ARGS__))(__VA_ARGS__) }, \
+                 FMT_NARGS(__VA_ARGS__))
+
+#endif
+
+// MARK: Compiled formats
+// ======================
+// A format string can be compiled once into a program of ops which can then be
+// executed any number of times without re-parsing the format string or resolving
+// the specifier types. The literal spans of a compiled program point into the
+// original format string, so it must outlive the program.
+
+/// A single step of a compiled format program. It writes a literal span of the
+/// format string followed by at most one formatted value.
+typedef struct fmt_op {
+  const char *literal;
+  size_t literal_len;
+  int index;           // argument index of the value or -1 if the op only writes a literal
+  int width_index;     // argument index of a '*' width or -1
+  int precision_index; // argument index of a '*' precision or -1
+  fmt_spec_t spec;     // the resolved specifier
+} fmt_op_t;
+
+/// A format string compiled by fmt_compile.
+typedef struct fmt_compiled {
+  const char *format;
+  fmt_op_t *ops;
+  int num_ops;
+  int max_ops;
+  int arg_count;
+  fmt_argtype_t argtypes[FMT_MAX_ARGS];
+  size_t max_len; // upper bound of the output length or SIZE_MAX if it is not bounded
+} fmt_compiled_t;
+
+/**
+ * Compiles a format string into a program of ops.
+ *
+ * A format string needs at most one op per specifier and escape sequence plus
+ * one for the trailing literal.
+ *
+ * @param format the format string
+ * @param [out] compiled the compiled format
+ * @param ops the storage for the ops of the program
+ * @param max_ops the number of ops in the storage
+ * @return the number of ops used or -1 if the program does not fit into max_ops
+ */
+int fmt_compile(const char *format, fmt_compiled_t *compiled, fmt_op_t *ops, int max_ops);
+
+/**
+ * Formats the arguments according to a compiled format. The output is identical
+ * to the output of fmt_format for the same format string.
+ *
+ * @param compiled the compiled format
+ * @param buffer the buffer to write to
+ * @param size the size of the buffer
+ * @param args the arguments
+ * @return the number of bytes written to the buffer
+ */
+size_t fmt_format_compiled(const fmt_compiled_t *compiled, char *buffer, size_t size, va_list args);
+
+/**
+ * Formats the arguments taken from an array according to a compiled format.
+ *
+ * @param compiled the compiled format
+ * @param buffer the buffer to write to
+ * @param size the size of the buffer
+ * @param args the arguments
+ * @param num_args the number of arguments
+ * @return the number of bytes written to the buffer
+ */
+size_t fmt_format_compiled_args(const fmt_compiled_t *compiled, char *buffer, size_t size, const fmt_arg_t *args, int num_args);
+
+/**
+ * Writes a string formatted according to a compiled format to the given fmt_buffer.
+ *
+ * @param buffer the buffer to write to
+ * @param compiled the compiled format
+ * @param ...
+ * @return the number of bytes written to the buffer
+ */
+size_t fmt_write_compiled(fmt_buffer_t *buffer, const fmt_compiled_t *compiled, ...);
+
+// MARK: Format cache
+// ===================
+// Once a cache is installed, fmt_format looks up the compiled program for the format
+// string by its address and only falls back to parsing it when the format is seen
+// for the first time. The cache is bounded by the storage it is given and entries
+// are never evicted. Formats that do not fit are formatted without the cache.
+//
+// Since the cache is keyed by address, formats built at runtime must be formatted
+// with fmt_format_nocache or fmt_write_nocache.
+
+typedef struct fmt_cache_entry {
+  const char *format; // published last, NULL while the entry is unused
+  fmt_compiled_t compiled;
+} fmt_cache_entry_t;
+
+typedef struct fmt_cache {
+  fmt_cache_entry_t *entries;
+  int num_entries;
+  fmt_op_t *ops;
+  int max_ops;
+  int used_ops;
+  int lock;
+  // statistics
+  size_t hits;
+  size_t misses;
+} fmt_cache_t;
+
+/// Defines a statically allocated cache with the given number of entries and ops.
+#define FMT_CACHE_DEFINE(name, n_entries, n_ops) \
+  static fmt_cache_entry_t name##_entries[n_entries]; \
+  static fmt_op_t name##_ops[n_ops]; \
+  static fmt_cache_t name = { \
+    .entries = name##_entries, .num_entries = (n_entries), \
+    .ops = name##_ops, .max_ops = (n_ops), \
+  }
+
+/**
+ * Initializes a format cache with caller-provided storage.
+ *
+ * @param cache the cache to initialize
+ * @param entries the storage for the cache entries
+ * @param num_entries the number of entries
+ * @param ops the storage shared by the compiled programs of all entries
+ * @param max_ops the number of ops in the storage
+ */
+void fmt_cache_init(fmt_cache_t *cache, fmt_cache_entry_t *entries, int num_entries, fmt_op_t *ops, int max_ops);
+
+/**
+ * Installs the cache used by fmt_format and fmt_write. Passing NULL disables caching.
+ * The cache must not be re-initialized while it is installed.
+ *
+ * @param cache the cache to install
+ */
+void fmt_cache_install(fmt_cache_t *cache);
+
+// MARK: Call-site formats
+// ========================
+// fmt_write_static gives each call site a hidden static slot which holds the compiled
+// format. The first call compiles the format and publishes it atomically, later calls
+// from any thread go straight to loading the arguments. The format must be the same
+// on every call from a call site, usually a string literal.
+
+typedef struct fmt_callsite {
+  int state;
+  fmt_compiled_t compiled;
+  fmt_op_t ops[FMT_CALLSITE_MAX_OPS];
+} fmt_callsite_t;
+
+/**
+ * Writes a formatted string to the given fmt_buffer using the compiled format
+ * of the call site, compiling it on first use.
+ *
+ * @param buffer the buffer to write to
+ * @param site the call site slot
+ * @param format the format string
+ * @param ...
+ * @return the number of bytes written to the buffer
+ */
+size_t fmt_write_callsite(fmt_buffer_t *buffer, fmt_callsite_t *site, const char *format, ...);
+
+/// Writes a formatted string to the given fmt_buffer using a compiled format
+/// cached at the call site: fmt_write_static(buffer, format, ...)
+#define fmt_write_static(buffer, ...) \
+  fmt_write_callsite(buffer, ({ static fmt_callsite_t _site; &_site; }), __VA_ARGS__)
+
+// MARK: Arrays
+// ============
+// fmt_write_array formats every element of an array with the same format, which takes
+// exactly one argument, and writes the separator between them. The element type follows
+// from the specifier like the type of an argument does, e.g. "{:d}" reads int elements,
+// "{:lld}" reads long long elements and "{:hg}" reads float elements. Formats which
+// consist of a single decimal integer specifier without a width, precision or sign are
+// converted several elements at a time.
+//
+//   fmt_write_array(&buffer, "{:d}", counts, num_counts, ",");
+
+/**
+ * Writes the elements of an array formatted according to the format to the given
+ * fmt_buffer, separated by the separator. Nothing is written if the format does not
+ * take exactly one argument of a known type.
+ *
+ * @param buffer the buffer to write to
+ * @param format the format of a single element
+ * @param values the elements
+ * @param count the number of elements
+ * @param separator the string written between the elements
+ * @return the number of bytes written to the buffer
+ */
+size_t fmt_write_array(fmt_buffer_t *buffer, const char *format, const void *values, size_t count, const char *separator);
+
 #endif
@@ -8,13 +8,19 @@
 
 #include <string.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #define min(a, b) ((a) < (b) ? (a) : (b))
 #define max(a, b) ((a) > (b) ? (a) : (b))
 
-// using a precision over 9 can lead to overflow errors
+// the library is built freestanding which turns every memcpy into a call, even for a
+// pair of digits. fixed-size copies use the builtin so that they are inlined.
+#define copy_fixed(dst, src, n) __builtin_memcpy(dst, src, n)
+
+// the precision of fixed and scientific doubles when none is given, as in printf
 #define PRECISION_DEFAULT 6
-#define PRECISION_MAX 9
-#define TEMP_BUFFER_SIZE (FMTLIB_MAX_WIDTH + 1)
 
 typedef struct fmt_format_type {
   const char *type;
@@ -31,251 +37,2092 @@ union double_raw {
   };
 };
 
-struct num_format {
-  int base;
-  const char *digits;
-  const char *prefix;
-};
+union float_raw {
+  float value;
+  struct {
+    uint32_t frac : 23;
+    uint32_t exp : 8;
+    uint32_t sign : 1;
+  };
+};
+
+struct num_format {
+  int base;
+  int shift; // log2 of the base if it is a power of two
+  const char *digits;
+  const char *prefix;
+};
+
+static const struct num_format binary_format = { .base = 2, .shift = 1, .digits = "01", .prefix = "0b" };
+static const struct num_format octal_format = { .base = 8, .shift = 3, .digits = "01234567", .prefix = "0o" };
+static const struct num_format decimal_format = { .base = 10, .shift = 0, .digits = "0123456789", .prefix = "" };
+static const struct num_format hex_lower_format = { .base = 16, .shift = 4, .digits = "0123456789abcdef", .prefix = "0x" };
+static const struct num_format hex_upper_format = { .base = 16, .shift = 4, .digits = "0123456789ABCDEF", .prefix = "0X" };
+
+// the digits of bases up to 62. bases up to 36 use the lowercase or uppercase letters
+// and larger bases use both.
+static const char radix_digits_lower[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+static const char radix_digits_upper[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+
+// the reciprocal of each base along with the largest power of the base which can be
+// split into digits using it. for a chunk value c below 2^32 / base, the quotient
+// c / base is exactly (c * recip) >> 32 where recip is 2^32 / base rounded up.
+static const struct radix_info {
+  uint32_t recip;
+  uint32_t chunk;
+  int chunk_len;
+} radix_table[63] = {
+  [2] = { 0x80000001u, 2147483648u, 31 },
+  [3] = { 0x55555556u, 1162261467u, 19 },
+  [4] = { 0x40000001u, 1073741824u, 15 },
+  [5] = { 0x33333334u, 244140625u, 12 },
+  [6] = { 0x2aaaaaabu, 362797056u, 11 },
+  [7] = { 0x24924925u, 282475249u, 10 },
+  [8] = { 0x20000001u, 134217728u, 9 },
+  [9] = { 0x1c71c71du, 387420489u, 9 },
+  [10] = { 0x1999999au, 100000000u, 8 },
+  [11] = { 0x1745d175u, 214358881u, 8 },
+  [12] = { 0x15555556u, 35831808u, 7 },
+  [13] = { 0x13b13b14u, 62748517u, 7 },
+  [14] = { 0x12492493u, 105413504u, 7 },
+  [15] = { 0x11111112u, 170859375u, 7 },
+  [16] = { 0x10000001u, 268435456u, 7 },
+  [17] = { 0x0f0f0f10u, 24137569u, 6 },
+  [18] = { 0x0e38e38fu, 34012224u, 6 },
+  [19] = { 0x0d79435fu, 47045881u, 6 },
+  [20] = { 0x0ccccccdu, 64000000u, 6 },
+  [21] = { 0x0c30c30du, 85766121u, 6 },
+  [22] = { 0x0ba2e8bbu, 113379904u, 6 },
+  [23] = { 0x0b21642du, 148035889u, 6 },
+  [24] = { 0x0aaaaaabu, 7962624u, 5 },
+  [25] = { 0x0a3d70a4u, 9765625u, 5 },
+  [26] = { 0x09d89d8au, 11881376u, 5 },
+  [27] = { 0x097b425fu, 14348907u, 5 },
+  [28] = { 0x0924924au, 17210368u, 5 },
+  [29] = { 0x08d3dcb1u, 20511149u, 5 },
+  [30] = { 0x08888889u, 24300000u, 5 },
+  [31] = { 0x08421085u, 28629151u, 5 },
+  [32] = { 0x08000001u, 33554432u, 5 },
+  [33] = { 0x07c1f07du, 39135393u, 5 },
+  [34] = { 0x07878788u, 45435424u, 5 },
+  [35] = { 0x07507508u, 52521875u, 5 },
+  [36] = { 0x071c71c8u, 60466176u, 5 },
+  [37] = { 0x06eb3e46u, 69343957u, 5 },
+  [38] = { 0x06bca1b0u, 79235168u, 5 },
+  [39] = { 0x06906907u, 90224199u, 5 },
+  [40] = { 0x06666667u, 102400000u, 5 },
+  [41] = { 0x063e7064u, 2825761u, 4 },
+  [42] = { 0x06186187u, 3111696u, 4 },
+  [43] = { 0x05f417d1u, 3418801u, 4 },
+  [44] = { 0x05d1745eu, 3748096u, 4 },
+  [45] = { 0x05b05b06u, 4100625u, 4 },
+  [46] = { 0x0590b217u, 4477456u, 4 },
+  [47] = { 0x0572620bu, 4879681u, 4 },
+  [48] = { 0x05555556u, 5308416u, 4 },
+  [49] = { 0x0539782au, 5764801u, 4 },
+  [50] = { 0x051eb852u, 6250000u, 4 },
+  [51] = { 0x05050506u, 6765201u, 4 },
+  [52] = { 0x04ec4ec5u, 7311616u, 4 },
+  [53] = { 0x04d4873fu, 7890481u, 4 },
+  [54] = { 0x04bda130u, 8503056u, 4 },
+  [55] = { 0x04a7904bu, 9150625u, 4 },
+  [56] = { 0x04924925u, 9834496u, 4 },
+  [57] = { 0x047dc120u, 10556001u, 4 },
+  [58] = { 0x0469ee59u, 11316496u, 4 },
+  [59] = { 0x0456c798u, 12117361u, 4 },
+  [60] = { 0x04444445u, 12960000u, 4 },
+  [61] = { 0x04325c54u, 13845841u, 4 },
+  [62] = { 0x04210843u, 14776336u, 4 },
+};
+
+static const uint64_t pow10_u64[] = {
+  1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+  1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull,
+  100000000000000ull, 1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+  1000000000000000000ull, 10000000000000000000ull,
+};
+
+// the digit tables are generated by the preprocessor. DIGITS_N(p) expands to all
+// N-digit strings prefixed with p, e.g. DIGITS_2("") is "00" "01" ... "99".
+#define DIGITS_1(p) p "0" p "1" p "2" p "3" p "4" p "5" p "6" p "7" p "8" p "9"
+#define DIGITS_2(p) DIGITS_1(p "0") DIGITS_1(p "1") DIGITS_1(p "2") DIGITS_1(p "3") DIGITS_1(p "4") \
+                    DIGITS_1(p "5") DIGITS_1(p "6") DIGITS_1(p "7") DIGITS_1(p "8") DIGITS_1(p "9")
+#define DIGITS_3(p) DIGITS_2(p "0") DIGITS_2(p "1") DIGITS_2(p "2") DIGITS_2(p "3") DIGITS_2(p "4") \
+                    DIGITS_2(p "5") DIGITS_2(p "6") DIGITS_2(p "7") DIGITS_2(p "8") DIGITS_2(p "9")
+#define DIGITS_4(p) DIGITS_3(p "0") DIGITS_3(p "1") DIGITS_3(p "2") DIGITS_3(p "3") DIGITS_3(p "4") \
+                    DIGITS_3(p "5") DIGITS_3(p "6") DIGITS_3(p "7") DIGITS_3(p "8") DIGITS_3(p "9")
+
+#if FMTLIB_DIGIT_TABLE == 4
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Woverlength-strings"
+static const char digit_quads[40001] = DIGITS_4("");
+#pragma GCC diagnostic pop
+// the last two digits of "00nn" are the pair nn
+#define DIGIT_PAIR(i) (&digit_quads[(i) * 4 + 2])
+#elif FMTLIB_DIGIT_TABLE == 2
+static const char digit_pairs[201] = DIGITS_2("");
+#define DIGIT_PAIR(i) (&digit_pairs[(i) * 2])
+#elif FMTLIB_DIGIT_TABLE != 0
+#error "FMTLIB_DIGIT_TABLE must be 0, 2 or 4"
+#endif
+
+// returns the number of decimal digits in a non-zero value. the bit length of the
+// value gives an estimate of its log10 (1233/4096 ~ log10(2)) which is off by at
+// most one, so a single comparison against the power of ten fixes it up.
+static inline int count_digits(uint64_t value) {
+  int t = ((64 - __builtin_clzll(value)) * 1233) >> 12;
+  return t + (value >= pow10_u64[t]);
+}
+
+// writes the decimal digits of value to the buffer back to front.
+static inline size_t u64_to_dec(uint64_t value, char *buffer) {
+  if (value == 0) {
+    buffer[0] = '0';
+    return 1;
+  }
+
+  size_t len = count_digits(value);
+  char *ptr = buffer + len;
+#if FMTLIB_DIGIT_TABLE == 4
+  while (value >= 10000) {
+    uint64_t q = value / 10000;
+    ptr -= 4;
+    copy_fixed(ptr, &digit_quads[(value - q * 10000) * 4], 4);
+    value = q;
+  }
+#endif
+#if FMTLIB_DIGIT_TABLE != 0
+  while (value >= 100) {
+    uint64_t q = value / 100;
+    ptr -= 2;
+    copy_fixed(ptr, DIGIT_PAIR(value - q * 100), 2);
+    value = q;
+  }
+  if (value >= 10) {
+    ptr -= 2;
+    copy_fixed(ptr, DIGIT_PAIR(value), 2);
+    return len;
+  }
+#else
+  while (value >= 10) {
+    uint64_t q = value / 10;
+    *--ptr = (char) ('0' + (value - q * 10));
+    value = q;
+  }
+#endif
+  *--ptr = (char) ('0' + value);
+  return len;
+}
+
+#if defined(__SSE2__)
+// expands all 16 nibbles of value to hex digits at once and copies the last len of
+// them to the buffer. letter is the offset of the first letter from '9' + 1.
+static inline size_t u64_to_hex_sse2(uint64_t value, char *buffer, size_t len, char letter) {
+  // the bytes are swapped so the most significant nibble ends up first
+  __m128i bytes = _mm_cvtsi64_si128((long long) __builtin_bswap64(value));
+  __m128i nibble_mask = _mm_set1_epi8(0x0F);
+  __m128i hi = _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble_mask);
+  __m128i lo = _mm_and_si128(bytes, nibble_mask);
+  __m128i nibbles = _mm_unpacklo_epi8(hi, lo);
+
+  // '0' + n for all nibbles and the letter offset for those above 9
+  __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)), _mm_set1_epi8(letter));
+  __m128i digits = _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letters);
+
+  char temp[16];
+  _mm_storeu_si128((__m128i *) temp, digits);
+  memcpy(buffer, temp + 16 - len, len);
+  return len;
+}
+
+// expands all 64 bits of value to binary digits and copies the last len of them to
+// the buffer. each 16 digits are made from two bytes which are broadcast to 8 lanes
+// each and compared against the mask of the bit each lane represents.
+static inline size_t u64_to_bin_sse2(uint64_t value, char *buffer, size_t len) {
+  const __m128i bits = _mm_set_epi8(1, 2, 4, 8, 16, 32, 64, (char) 128, 1, 2, 4, 8, 16, 32, 64, (char) 128);
+  const __m128i zero = _mm_set1_epi8('0');
+
+  char temp[64];
+  for (int i = 0; i < 4; i++) {
+    uint64_t hi = (value >> (56 - i * 16)) & 0xFF;
+    uint64_t lo = (value >> (48 - i * 16)) & 0xFF;
+    __m128i v = _mm_set_epi64x((long long) (lo * 0x0101010101010101ull), (long long) (hi * 0x0101010101010101ull));
+    __m128i set = _mm_cmpeq_epi8(_mm_and_si128(v, bits), bits);
+    // set lanes are -1 so subtracting them turns '0' into '1'
+    _mm_storeu_si128((__m128i *) (temp + i * 16), _mm_sub_epi8(zero, set));
+  }
+  memcpy(buffer, temp + 64 - len, len);
+  return len;
+}
+
+// copies 8 bytes between unaligned addresses. the library is built freestanding, so
+// this keeps fixed-size copies in the batch loop from becoming calls to memcpy.
+static inline void copy8_sse2(char *dst, const char *src) {
+  _mm_storel_epi64((__m128i *) dst, _mm_loadl_epi64((const __m128i *) src));
+}
+
+// converts four values below 10^8 to 8 decimal digits each, padded with leading zeros,
+// and writes the 32 digits to the buffer. the values are split into two groups of four
+// digits by a multiply-high with the reciprocal of 10^4. each group is broadcast to four
+// 16-bit lanes which are divided by 10^3, 10^2, 10^1 and 10^0 the same way. this leaves
+// a, ab, abc and abcd in the lanes and subtracting ten times the lane before each of
+// them leaves the digits.
+static inline void u32x4_to_dec_sse2(__m128i values, char *buffer) {
+  const __m128i div_10000 = _mm_set1_epi32((int) 0xD1B71759);
+  const __m128i div_powers = _mm_setr_epi16(8389, 5243, 13108, (short) 32768, 8389, 5243, 13108, (short) 32768);
+  const __m128i shift_powers = _mm_setr_epi16(1 << 7, 1 << 11, 1 << 13, (short) (1 << 15), 1 << 7, 1 << 11, 1 << 13, (short) (1 << 15));
+
+  __m128i hi_even = _mm_srli_epi64(_mm_mul_epu32(values, div_10000), 45);
+  __m128i hi_odd = _mm_srli_epi64(_mm_mul_epu32(_mm_srli_epi64(values, 32), div_10000), 45);
+  __m128i hi = _mm_or_si128(hi_even, _mm_slli_epi64(hi_odd, 32));
+  __m128i lo = _mm_sub_epi32(values, _mm_madd_epi16(hi, _mm_set1_epi32(10000)));
+
+  // [hi0, lo0, hi1, lo1, ...] times four, which keeps the quotients exact
+  __m128i groups = _mm_slli_epi16(_mm_or_si128(hi, _mm_slli_epi32(lo, 16)), 2);
+  __m128i pairs_lo = _mm_unpacklo_epi16(groups, groups);
+  __m128i pairs_hi = _mm_unpackhi_epi16(groups, groups);
+  __m128i lanes[4] = {
+    _mm_unpacklo_epi32(pairs_lo, pairs_lo),
+    _mm_unpackhi_epi32(pairs_lo, pairs_lo),
+    _mm_unpacklo_epi32(pairs_hi, pairs_hi),
+    _mm_unpackhi_epi32(pairs_hi, pairs_hi),
+  };
+  for (int i = 0; i < 4; i++) {
+    __m128i q = _mm_mulhi_epu16(_mm_mulhi_epu16(lanes[i], div_powers), shift_powers);
+    __m128i tens = _mm_slli_epi64(_mm_mullo_epi16(q, _mm_set1_epi16(10)), 16);
+    lanes[i] = _mm_sub_epi16(q, tens);
+  }
+
+  const __m128i zero = _mm_set1_epi8('0');
+  _mm_storeu_si128((__m128i *) buffer, _mm_add_epi8(_mm_packus_epi16(lanes[0], lanes[1]), zero));
+  _mm_storeu_si128((__m128i *) (buffer + 16), _mm_add_epi8(_mm_packus_epi16(lanes[2], lanes[3]), zero));
+}
+#endif
+
+// writes exactly len digits of value in a power of two base to the buffer. the digits
+// are extracted with shifts from the least significant end.
+static inline size_t u64_to_pow2_len(uint64_t value, char *buffer, size_t len, const struct num_format *format) {
+  int shift = format->shift;
+#if defined(__SSE2__)
+  if (shift == 4) {
+    return u64_to_hex_sse2(value, buffer, len, (char) (format->digits[10] - '9' - 1));
+  } else if (shift == 1) {
+    return u64_to_bin_sse2(value, buffer, len);
+  }
+#endif
+
+  const char *digits = format->digits;
+  uint64_t mask = format->base - 1;
+  char *ptr = buffer + len;
+  while (ptr > buffer) {
+    *--ptr = digits[value & mask];
+    value >>= shift;
+  }
+  return len;
+}
+
+// writes the digits of value in a power of two base to the buffer. the number of digits
+// follows from the bit length of the value.
+static inline size_t u64_to_pow2(uint64_t value, char *buffer, const struct num_format *format) {
+  if (value == 0) {
+    buffer[0] = '0';
+    return 1;
+  }
+
+  int shift = format->shift;
+  size_t len = (64 - __builtin_clzll(value) + shift - 1) / shift;
+  return u64_to_pow2_len(value, buffer, len, format);
+}
+
+// writes the digits of value in any base from 3 to 62. the value is split into chunks
+// of several digits with one hardware division each and the digits of each chunk are
+// extracted by multiplying with the reciprocal of the base.
+static inline size_t u64_to_radix(uint64_t value, char *buffer, const struct num_format *format) {
+  const struct radix_info *radix = &radix_table[format->base];
+  const char *digits = format->digits;
+  uint32_t base = format->base;
+
+  char temp[64];
+  char *ptr = temp + sizeof(temp);
+  while (value >= radix->chunk) {
+    uint64_t q = value / radix->chunk;
+    uint32_t c = (uint32_t) (value - q * radix->chunk);
+    for (int i = 0; i < radix->chunk_len; i++) {
+      uint32_t d = (uint32_t) (((uint64_t) c * radix->recip) >> 32);
+      *--ptr = digits[c - d * base];
+      c = d;
+    }
+    value = q;
+  }
+
+  uint32_t c = (uint32_t) value;
+  do {
+    uint32_t d = (uint32_t) (((uint64_t) c * radix->recip) >> 32);
+    *--ptr = digits[c - d * base];
+    c = d;
+  } while (c > 0);
+
+  size_t len = temp + sizeof(temp) - ptr;
+  memcpy(buffer, ptr, len);
+  return len;
+}
+
+static inline size_t u64_to_str(uint64_t value, char *buffer, const struct num_format *format) {
+  if (format->shift == 0) {
+    if (format->base != 10) {
+      return u64_to_radix(value, buffer, format);
+    }
+    return u64_to_dec(value, buffer);
+  }
+  return u64_to_pow2(value, buffer, format);
+}
+
+// writes exactly len decimal digits of value to the buffer, padded with leading zeros.
+static inline void u64_to_dec_len(uint64_t value, char *buffer, size_t len) {
+  size_t digits = value == 0 ? 0 : (size_t) count_digits(value);
+  memset(buffer, '0', len - digits);
+  if (digits > 0) {
+    u64_to_dec(value, buffer + len - digits);
+  }
+}
+
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 uint128_t;
+__extension__ typedef __int128 int128_t;
+
+// divides hi:lo by a 64-bit divisor which is larger than hi, so that the quotient fits
+// in 64 bits, and returns the quotient and remainder.
+static inline uint64_t u128_div_u64(uint64_t hi, uint64_t lo, uint64_t divisor, uint64_t *rem) {
+#if defined(__x86_64__)
+  uint64_t q;
+  __asm__("divq %4" : "=a"(q), "=d"(*rem) : "a"(lo), "d"(hi), "rm"(divisor));
+  return q;
+#else
+  uint128_t value = ((uint128_t) hi << 64) | lo;
+  uint64_t q = (uint64_t) (value / divisor);
+  *rem = lo - q * divisor;
+  return q;
+#endif
+}
+
+// writes the decimal digits of a 128-bit value to the buffer. the value is split into
+// chunks of 19 digits by dividing by 10^19, the largest power of ten that fits in 64
+// bits, and each chunk is converted with the 64-bit routine.
+static inline size_t u128_to_dec(uint128_t value, char *buffer) {
+  const uint64_t chunk = 10000000000000000000ull;
+  uint64_t hi = (uint64_t) (value >> 64);
+  uint64_t lo = (uint64_t) value;
+  if (hi == 0) {
+    return u64_to_dec(lo, buffer);
+  }
+
+  // long division of hi:lo by 10^19. the high half is below 2 * 10^19 so its
+  // quotient is at most 1 and the remaining division has a 64-bit quotient.
+  uint64_t q_hi = 0;
+  if (hi >= chunk) {
+    q_hi = 1;
+    hi -= chunk;
+  }
+  uint64_t low_digits;
+  uint64_t q = u128_div_u64(hi, lo, chunk, &low_digits);
+
+  size_t len;
+  if (q_hi == 0 && q < chunk) {
+    len = u64_to_dec(q, buffer);
+  } else {
+    // values of 10^38 and above have a 39th digit
+    uint64_t mid_digits;
+    uint64_t top = u128_div_u64(q_hi, q, chunk, &mid_digits);
+    buffer[0] = (char) ('0' + top);
+    u64_to_dec_len(mid_digits, buffer + 1, 19);
+    len = 20;
+  }
+  u64_to_dec_len(low_digits, buffer + len, 19);
+  return len + 19;
+}
+
+// writes the digits of a 128-bit value in a power of two base to the buffer. for hex
+// and binary the digits of each half are independent so the high half is written as
+// usual and the low half with a fixed number of digits.
+static inline size_t u128_to_pow2(uint128_t value, char *buffer, const struct num_format *format) {
+  uint64_t hi = (uint64_t) (value >> 64);
+  uint64_t lo = (uint64_t) value;
+  if (hi == 0) {
+    return u64_to_pow2(lo, buffer, format);
+  }
+
+  int shift = format->shift;
+  if (64 % shift == 0) {
+    size_t len = u64_to_pow2(hi, buffer, format);
+    return len + u64_to_pow2_len(lo, buffer + len, 64 / shift, format);
+  }
+
+  // octal digits straddle the halves
+  const char *digits = format->digits;
+  uint64_t mask = format->base - 1;
+  size_t len = (128 - __builtin_clzll(hi) + shift - 1) / shift;
+  char *ptr = buffer + len;
+  while (ptr > buffer) {
+    *--ptr = digits[(uint64_t) value & mask];
+    value >>= shift;
+  }
+  return len;
+}
+
+static inline size_t u128_to_str(uint128_t value, char *buffer, const struct num_format *format) {
+  if (format->shift == 0) {
+    return u128_to_dec(value, buffer);
+  }
+  return u128_to_pow2(value, buffer, format);
+}
+
+// MARK: Big integers
+// big integers are converted by divide-and-conquer. the value is divided by a power
+// of ten 10^(19 * 2^k) and the quotient and remainder are converted recursively until
+// the parts are single limbs below 10^19, which are converted as 64-bit integers.
+// all of the limbs for the powers, quotients and remainders come from a scratch area
+// of BIGINT_SCRATCH_LIMBS(count) limbs, which is on the stack for values of up to
+// FMTLIB_BIGINT_MAX_LIMBS and is provided by the caller for larger ones.
+
+#define BIGINT_MAX_POWERS 24
+#define BIGINT_MAX_COUNT ((size_t) 1 << 24) // largest value the powers are enough for
+#define BIGINT_LEAF_LIMBS 4
+#define BIGINT_SCRATCH_LIMBS(count) (6 * (count) + 3 * BIGINT_MAX_POWERS + 8)
+
+struct bigint_ctx {
+  uint64_t *scratch;
+  size_t used;
+  const uint64_t *pow[BIGINT_MAX_POWERS]; // 10^(19 * 2^k)
+  size_t pow_len[BIGINT_MAX_POWERS];
+};
+
+static inline size_t bigint_trim(const uint64_t *a, size_t n) {
+  while (n > 0 && a[n-1] == 0) {
+    n--;
+  }
+  return n;
+}
+
+// writes the an + bn limb product of a and b to out.
+static void bigint_mul(const uint64_t *a, size_t an, const uint64_t *b, size_t bn, uint64_t *out) {
+  memset(out, 0, (an + bn) * sizeof(uint64_t));
+  for (size_t i = 0; i < an; i++) {
+    uint64_t carry = 0;
+    for (size_t j = 0; j < bn; j++) {
+      uint128_t p = (uint128_t) a[i] * b[j] + out[i+j] + carry;
+      out[i+j] = (uint64_t) p;
+      carry = (uint64_t) (p >> 64);
+    }
+    out[i+bn] = carry;
+  }
+}
+
+// divides u by d and writes the un - dn + 1 limb quotient to q and the dn limb
+// remainder to r. this is the schoolbook division from knuth (algorithm D) which
+// needs un + dn + 1 limbs of work space. d must have at least two limbs.
+static void bigint_divmod(const uint64_t *u, size_t un, const uint64_t *d, size_t dn, uint64_t *q, uint64_t *r, uint64_t *work) {
+  // normalize so the top bit of the divisor is set
+  int s = __builtin_clzll(d[dn-1]);
+  uint64_t *vn = work;
+  uint64_t *rem = work + dn;
+  for (size_t i = dn - 1; i > 0; i--) {
+    vn[i] = (d[i] << s) | (s ? d[i-1] >> (64 - s) : 0);
+  }
+  vn[0] = d[0] << s;
+  rem[un] = s ? u[un-1] >> (64 - s) : 0;
+  for (size_t i = un - 1; i > 0; i--) {
+    rem[i] = (u[i] << s) | (s ? u[i-1] >> (64 - s) : 0);
+  }
+  rem[0] = u[0] << s;
+
+  uint64_t dtop = vn[dn-1];
+  for (size_t j = un - dn + 1; j-- > 0;) {
+    // estimate the quotient limb from the top two limbs and correct it with the next
+    uint64_t qhat, rhat;
+    bool rhat_overflow = false;
+    if (rem[j+dn] >= dtop) {
+      qhat = UINT64_MAX;
+      rhat = rem[j+dn-1] + dtop;
+      rhat_overflow = rhat < dtop;
+    } else {
+      qhat = u128_div_u64(rem[j+dn], rem[j+dn-1], dtop, &rhat);
+    }
+    while (!rhat_overflow && (uint128_t) qhat * vn[dn-2] > (((uint128_t) rhat << 64) | rem[j+dn-2])) {
+      qhat--;
+      rhat += dtop;
+      rhat_overflow = rhat < dtop;
+    }
+
+    // multiply and subtract. the borrow is folded into the carry of the product,
+    // which is at most 2^64 - 2.
+    uint64_t carry = 0;
+    for (size_t i = 0; i < dn; i++) {
+      uint128_t p = (uint128_t) qhat * vn[i] + carry;
+      uint64_t lo = (uint64_t) p;
+      uint64_t x = rem[i+j];
+      rem[i+j] = x - lo;
+      carry = (uint64_t) (p >> 64) + (x < lo);
+    }
+    uint64_t x = rem[j+dn];
+    rem[j+dn] = x - carry;
+
+    // the estimate was one too large, add the divisor back
+    if (x < carry) {
+      qhat--;
+      carry = 0;
+      for (size_t i = 0; i < dn; i++) {
+        uint128_t sum = (uint128_t) rem[i+j] + vn[i] + carry;
+        rem[i+j] = (uint64_t) sum;
+        carry = (uint64_t) (sum >> 64);
+      }
+      rem[j+dn] += carry;
+    }
+    q[j] = qhat;
+  }
+
+  // unnormalize the remainder
+  for (size_t i = 0; i < dn - 1; i++) {
+    r[i] = (rem[i] >> s) | (s ? rem[i+1] << (64 - s) : 0);
+  }
+  r[dn-1] = rem[dn-1] >> s;
+}
+
+// writes the decimal digits of a small value by repeatedly dividing it by 10^19. the
+// output is padded with leading zeros to len digits if len is not 0.
+static char *bigint_to_dec_leaf(struct bigint_ctx *ctx, const uint64_t *u, size_t un, size_t len, char *out) {
+  uint64_t *t = ctx->scratch + ctx->used;
+  memcpy(t, u, un * sizeof(uint64_t));
+
+  // the chunks are produced from the least significant end
+  char *end = out + (len > 0 ? len : un * 20);
+  char *ptr = end;
+  while (un > 1) {
+    uint64_t rem = 0;
+    for (size_t i = un; i-- > 0;) {
+      t[i] = u128_div_u64(rem, t[i], 10000000000000000000ull, &rem);
+    }
+    ptr -= 19;
+    u64_to_dec_len(rem, ptr, 19);
+    un = bigint_trim(t, un);
+  }
+
+  uint64_t top = un > 0 ? t[0] : 0;
+  if (len > 0) {
+    ptr -= 19;
+    u64_to_dec_len(top, ptr, 19);
+    memset(out, '0', ptr - out);
+    return end;
+  }
+
+  // unpadded output is moved to the front
+  size_t top_len = u64_to_dec(top, out);
+  size_t rest = end - ptr;
+  memmove(out + top_len, ptr, rest);
+  return out + top_len + rest;
+}
+
+// divides u by the power 10^(19 * 2^k) and returns the quotient and remainder, which
+// are allocated from the scratch area.
+static void bigint_divmod_pow(struct bigint_ctx *ctx, const uint64_t *u, size_t un, int k, uint64_t **q, uint64_t **r) {
+  const uint64_t *d = ctx->pow[k];
+  size_t dn = ctx->pow_len[k];
+  size_t qn = un - dn + 1;
+  *q = ctx->scratch + ctx->used;
+  *r = *q + qn;
+  if (dn == 1) {
+    uint64_t rem = 0;
+    for (size_t i = un; i-- > 0;) {
+      (*q)[i] = u128_div_u64(rem, u[i], d[0], &rem);
+    }
+    (*r)[0] = rem;
+  } else {
+    bigint_divmod(u, un, d, dn, *q, *r, *r + dn);
+  }
+  ctx->used += qn + dn;
+}
+
+// writes all 19 * 2^(k+1) decimal digits of u which is below (10^(19 * 2^k))^2,
+// including leading zeros. returns the end of the written digits.
+static char *bigint_to_dec_padded(struct bigint_ctx *ctx, const uint64_t *u, size_t un, int k, char *out) {
+  size_t len = (size_t) 38 << k;
+  un = bigint_trim(u, un);
+  if (un <= BIGINT_LEAF_LIMBS) {
+    return bigint_to_dec_leaf(ctx, u, un, len, out);
+  }
+
+  size_t used = ctx->used;
+  uint64_t *q, *r;
+  bigint_divmod_pow(ctx, u, un, k, &q, &r);
+  out = bigint_to_dec_padded(ctx, q, un - ctx->pow_len[k] + 1, k - 1, out);
+  out = bigint_to_dec_padded(ctx, r, ctx->pow_len[k], k - 1, out);
+  ctx->used = used;
+  return out;
+}
+
+// writes the decimal digits of u without leading zeros. the value is split by the
+// largest power which has at most half of its limbs, the quotient is converted in
+// the same way and the remainder is converted with all of its digits.
+static char *bigint_to_dec(struct bigint_ctx *ctx, const uint64_t *u, size_t un, char *out) {
+  if (un <= BIGINT_LEAF_LIMBS) {
+    return bigint_to_dec_leaf(ctx, u, un, 0, out);
+  }
+
+  int k = 0;
+  while (k + 1 < BIGINT_MAX_POWERS && ctx->pow[k+1] != NULL && 2 * ctx->pow_len[k+1] <= un) {
+    k++;
+  }
+
+  size_t used = ctx->used;
+  uint64_t *q, *r;
+  bigint_divmod_pow(ctx, u, un, k, &q, &r);
+  out = bigint_to_dec(ctx, q, bigint_trim(q, un - ctx->pow_len[k] + 1), out);
+  if (k == 0) {
+    u64_to_dec_len(r[0], out, 19);
+    out += 19;
+  } else {
+    out = bigint_to_dec_padded(ctx, r, ctx->pow_len[k], k - 1, out);
+  }
+  ctx->used = used;
+  return out;
+}
+
+// writes the decimal digits of a value of n limbs to the buffer which must have room
+// for 20 digits per limb. the scratch area must have BIGINT_SCRATCH_LIMBS(n) limbs.
+static inline size_t bigint_to_str(const uint64_t *limbs, size_t n, uint64_t *scratch, char *buffer) {
+  struct bigint_ctx ctx = { .scratch = scratch };
+
+  // square the powers of ten up to about half the size of the value
+  static const uint64_t pow19 = 10000000000000000000ull;
+  ctx.pow[0] = &pow19;
+  ctx.pow_len[0] = 1;
+  for (int k = 0; n > BIGINT_LEAF_LIMBS && 4 * ctx.pow_len[k] <= n; k++) {
+    uint64_t *sq = ctx.scratch + ctx.used;
+    bigint_mul(ctx.pow[k], ctx.pow_len[k], ctx.pow[k], ctx.pow_len[k], sq);
+    ctx.pow[k+1] = sq;
+    ctx.pow_len[k+1] = bigint_trim(sq, 2 * ctx.pow_len[k]);
+    ctx.used += ctx.pow_len[k+1];
+  }
+  return bigint_to_dec(&ctx, limbs, n, buffer) - buffer;
+}
+
+// writes the decimal digits of a value of at most FMTLIB_BIGINT_MAX_LIMBS limbs with
+// the scratch area on the stack.
+__attribute__((noinline))
+static size_t bigint_to_str_small(const uint64_t *limbs, size_t n, char *buffer) {
+  uint64_t scratch[BIGINT_SCRATCH_LIMBS(FMTLIB_BIGINT_MAX_LIMBS)];
+  return bigint_to_str(limbs, n, scratch, buffer);
+}
+#endif
+
+// Writes the sign, prefix and digits of a number to the buffer. the precision and zero
+// padding of the spec are applied in between.
+static inline size_t write_integer(fmt_buffer_t *buffer, const fmt_spec_t *spec, bool is_negative, const struct num_format *format,
+                                   const char *digits, size_t len) {
+  size_t width = spec->width;
+  size_t n = 0;
+
+  // write sign or space to buffer
+  if (is_negative) {
+    n += fmtlib_buffer_write_char(buffer, '-');
+  } else if (spec->flags & FMT_FLAG_SIGN) {
+    n += fmtlib_buffer_write_char(buffer, '+');
+  } else if (spec->flags & FMT_FLAG_SPACE) {
+    n += fmtlib_buffer_write_char(buffer, ' ');
+  }
+
+  // write prefix for alternate form (e.g. 0x) to buffer
+  if (spec->flags & FMT_FLAG_ALT) {
+    const char *ptr = format->prefix;
+    while (*ptr) {
+      n += fmtlib_buffer_write_char(buffer, *ptr++);
+    }
+  }
+
+  // pad with leading zeros to reach specified precision
+  if ((size_t)spec->precision > len) {
+    n += fmtlib_buffer_fill(buffer, '0', spec->precision - len);
+  }
+
+  // left-pad number with zeros to reach specified width
+  if (spec->flags & FMT_FLAG_ZERO && width > len + n) {
+    // normally padding is handled outside of this function and is applied to the
+    // entire number including the sign or prefix. however, when the zero flag is
+    // set, the zero padding is applied to the number only and keeps the sign or
+    // prefix in front of the number.
+    n += fmtlib_buffer_fill(buffer, '0', width - len - n);
+  }
+
+  // finally write the number to the buffer
+  n += fmtlib_buffer_write(buffer, digits, len);
+  return n;
+}
+
+// Writes a signed or unsigned number to the buffer using the given format.
+static inline size_t format_integer(fmt_buffer_t *buffer, const fmt_spec_t *spec, bool is_signed, const struct num_format *format) {
+  uint64_t v;
+  bool is_negative = false;
+  if (is_signed) {
+    int64_t i = (int64_t) spec->value.uint64_value;
+    if (i < 0) {
+      v = -(uint64_t) i;
+      is_negative = true;
+    } else {
+      v = i;
+    }
+  } else {
+    v = spec->value.uint64_value;
+  }
+
+  // write digits to an intermediate buffer so we can calculate the
+  // length of the number and apply precision and padding accordingly
+  char temp[64];
+  size_t len = u64_to_str(v, temp, format);
+  return write_integer(buffer, spec, is_negative, format, temp, len);
+}
+
+static size_t format_signed(fmt_buffer_t *buffer, const fmt_spec_t *spec) {
+  return format_integer(buffer, spec, true, &decimal_format);
+}
+
+static size_t format_unsigned(fmt_buffer_t *buffer, const fmt_spec_t *spec) {
+  return format_integer(buffer, spec, false, &decimal_format);
+}
+
+static size_t format_binary(fmt_buffer_t *buffer, const fmt_spec_t *spec) {
+  return format_integer(buffer, spec, false, &binary_format);
+}
+
+static size_t format_octal(fmt_buffer_t *buffer, const fmt_spec_t *spec) {
+  return format_integer(buffer, spec, false, &octal_format);
+}
+
+static size_t format_hex(fmt_buffer_t *buffer, const fmt_spec_t *spec) {
+  if (spec->flags & FMT_FLAG_UPPER) {
+    return format_integer(buffer, spec, false, &hex_upper_format);
+  } else {
+    return format_integer(buffer, spec, false, &hex_lower_format);
+  }
+}
+
+// Writes a decimal or power of two integer together with the padding of the spec
+// straight to the buffer, which must have room for the longest output of the spec.
+// since the length of the digits is known up front, everything is written in order
+// without an intermediate buffer or any bounds checks.
+static size_t put_integer(fmt_buffer_t *buffer, const fmt_spec_t *spec, bool is_signed, const struct num_format *format) {
+  uint64_t v = spec->value.uint64_value;
+  bool is_negative = is_signed && (int64_t) v < 0;
+  v = is_negative ? -v : v;
+
+  int shift = format->shift;
+  size_t len = 1;
+  if (v != 0) {
+    len = shift ? (size_t) (64 - __builtin_clzll(v) + shift - 1) / shift : (size_t) count_digits(v);
+  }
+
+  char sign = 0;
+  if (is_negative) {
+    sign = '-';
+  } else if (spec->flags & FMT_FLAG_SIGN) {
+    sign = '+';
+  } else if (spec->flags & FMT_FLAG_SPACE) {
+    sign = ' ';
+  }
+
+  // all prefixes are two characters long
+  size_t prefix_len = (spec->flags & FMT_FLAG_ALT) && format->prefix[0] ? 2 : 0;
+  size_t zeros = spec->precision > len ? spec->precision - len : 0;
+  size_t body = (sign != 0) + prefix_len + zeros + len;
+  size_t width = spec->width;
+  if ((spec->flags & FMT_FLAG_ZERO) && width > body) {
+    zeros += width - body;
+    body = width;
+  }
+
+  size_t padding = width > body ? width - body : 0;
+  size_t before = 0;
+  if (spec->align == FMT_ALIGN_RIGHT) {
+    before = padding;
+  } else if (spec->align == FMT_ALIGN_CENTER) {
+    before = padding / 2;
+  }
+
+  char *ptr = buffer->data;
+  if (before > 0) {
+    memset(ptr, spec->fill_char, before);
+    ptr += before;
+  }
+  *ptr = sign;
+  ptr += sign != 0;
+  if (prefix_len > 0) {
+    ptr[0] = format->prefix[0];
+    ptr[1] = format->prefix[1];
+    ptr += 2;
+  }
+  if (zeros > 0) {
+    memset(ptr, '0', zeros);
+    ptr += zeros;
+  }
+  ptr += shift ? u64_to_pow2_len(v, ptr, len, format) : u64_to_dec(v, ptr);
+  if (padding > before) {
+    memset(ptr, spec->fill_char, padding - before);
+    ptr += padding - before;
+  }
+
+  size_t n = ptr - buffer->data;
+  buffer->data = ptr;
+  buffer->size -= n;
+  buffer->written += n;
+  return n;
+}
+
+// parses the base of a radix type (e.g. "36" in "r36") and returns it or 0 if it is
+// not a number between 2 and 62.
+static inline int parse_radix(const char *ptr) {
+  if (ptr[0] < '0' || ptr[0] > '9') {
+    return 0;
+  }
+
+  int base = ptr[0] - '0';
+  if (ptr[1] >= '0' && ptr[1] <= '9') {
+    base = base * 10 + (ptr[1] - '0');
+  }
+  return base >= 2 && base <= 62 ? base : 0;
+}
+
+static size_t format_radix(fmt_buffer_t *buffer, const fmt_spec_t *spec) {
+  int base = spec->base;
+  struct num_format format = {
+    .base = base,
+    .shift = (base & (base - 1)) == 0 ? __builtin_ctz(base) : 0,
+    .digits = spec->flags & FMT_FLAG_UPPER ? radix_digits_upper : radix_digits_lower,
+    .prefix = "",
+  };
+  return format_integer(buffer, spec, false, &format);
+}
+
+// Writes a signed integer with an implied decimal scale given by the precision, e.g. 1234
+// with a precision of 2 is written as 12.34. the integer and the fraction are split with
+// a single division by the power of ten so no floating point is involved.
+static size_t format_fixed(fmt_buffer_t *buffer, const fmt_spec_t *spec) {
+  int64_t i = (int64_t) spec->value.uint64_value;
+  bool is_negative = i < 0;
+  uint64_t v = is_negative ? -(uint64_t) i : (uint64_t) i;
+  size_t scale = spec->precision;
+
+  // the precision is the scale here, not the minimum number of digits
+  fmt_spec_t int_spec = *spec;
+  int_spec.precision = 0;
+
+  char temp[48];
+  size_t len;
+  if (scale < 20) {
+    uint64_t pow = pow10_u64[scale];
+    uint64_t int_part = v / pow;
+    len = u64_to_dec(int_part, temp);
+    if (scale > 0) {
+      temp[len++] = '.';
+      u64_to_dec_len(v - int_part * pow, temp + len, scale);
+      len += scale;
+    }
+    return write_integer(buffer, &int_spec, is_negative, &decimal_format, temp, len);
+  }
+
+  // every digit of the value is part of the fraction and is preceded by zeros. only
+  // the "0." goes through write_integer, with the width that is left for it.
+  size_t zeros = scale - 20;
+  size_t width = spec->width;
+  int_spec.width = width > scale ? width - scale : 0;
+  size_t n = write_integer(buffer, &int_spec, is_negative, &decimal_format, "0.", 2);
+  n += fmtlib_buffer_fill(buffer, '0', zeros);
+  u64_to_dec_len(v, temp, 20);
+  n += fmtlib_buffer_write(buffer, temp, 20);
+  return n;
+}
+
+#if defined(__SIZEOF_INT128__)
+// Writes a 128-bit number to the buffer using the given format. the value is too large
+// for the spec so the argument is a pointer to it.
+static inline size_t format_integer128(fmt_buffer_t *buffer, const fmt_spec_t *spec, bool is_signed, const struct num_format *format) {
+  const void *ptr = spec->value.voidptr_value;
+  if (ptr == NULL) {
+    return fmtlib_buffer_write(buffer, "(null)", 6);
+  }
+
+  uint128_t v;
+  memcpy(&v, ptr, sizeof(v));
+  bool is_negative = is_signed && (int128_t) v < 0;
+  if (is_negative) {
+    v = -v;
+  }
+
+  char temp[128];
+  size_t len = u128_to_str(v, temp, format);
+  return write_integer(buffer, spec, is_negative, format, temp, len);
+}
+
+static size_t format_signed128(fmt_buffer_t *buffer, const fmt_spec_t *spec) {
+  return format_integer128(buffer, spec, true, &decimal_format);
+}
+
+static size_t format_unsigned128(fmt_buffer_t *buffer, const fmt_spec_t *spec) {
+  return format_integer128(buffer, spec, false, &decimal_format);
+}
+
+static size_t format_binary128(fmt_buffer_t *buffer, const fmt_spec_t *spec) {
+  return format_integer128(buffer, spec, false, &binary_format);
+}
+
+static size_t format_octal128(fmt_buffer_t *buffer, const fmt_spec_t *spec) {
+  return format_integer128(buffer, spec, false, &octal_format);
+}
+
+static size_t format_hex128(fmt_buffer_t *buffer, const fmt_spec_t *spec) {
+  if (spec->flags & FMT_FLAG_UPPER) {
+    return format_integer128(buffer, spec, false, &hex_upper_format);
+  } else {
+    return format_integer128(buffer, spec, false, &hex_lower_format);
+  }
+}
+
+// Writes a big integer to the buffer in decimal. the argument is a pointer to a
+// fmt_bigint_t.
+static size_t format_bigint(fmt_buffer_t *buffer, const fmt_spec_t *spec) {
+  const fmt_bigint_t *value = spec->value.voidptr_value;
+  if (value == NULL) {
+    return fmtlib_buffer_write(buffer, "(null)", 6);
+  }
+
+  size_t n = bigint_trim(value->limbs, value->count);
+  if (n > FMTLIB_BIGINT_MAX_LIMBS) {
+    if (n > BIGINT_MAX_COUNT || value->scratch == NULL || value->scratch_count < FMTLIB_BIGINT_SCRATCH_LIMBS(n)) {
+      return fmtlib_buffer_write(buffer, "{bigint too large}", 18);
+    }
+    // the digits go after the limbs used by the conversion
+    char *digits = (char *) (value->scratch + BIGINT_SCRATCH_LIMBS(n));
+    size_t len = bigint_to_str(value->limbs, n, value->scratch, digits);
+    return write_integer(buffer, spec, value->negative, &decimal_format, digits, len);
+  }
+
+  char temp[FMTLIB_BIGINT_MAX_LIMBS * 20];
+  size_t len = bigint_to_str_small(value->limbs, n, temp);
+  return write_integer(buffer, spec, value->negative && n > 0, &decimal_format, temp, len);
+}
+#endif
+
+// MARK: Fixed doubles
+//
+// doubles are written in fixed notation from their exact binary value m * 2^e2, so the
+// digits are correctly rounded at any precision and magnitude. integer parts which do
+// not fit in 64 bits are converted like a big integer. the fraction is multiplied by
+// powers of ten and the digits are taken from what carries out above the binary point.
+// fractions of up to 60 bits fit in a single word, which covers values above about 0.01.
+
+#define FIXED_INT_DIGITS 309   // digits in the integer part of the largest double
+#define FIXED_FRAC_DIGITS 1074 // digits in the fraction of the smallest subnormal
+#define FIXED_LIMBS 34         // 32-bit limbs needed for a 1074 bit fraction
+
+// Writes the decimal digits of m * 2^e2 to the buffer for e2 > 11, where the value does
+// not fit in 64 bits. returns the number of digits written.
+static size_t shifted_to_dec(uint64_t m, int e2, char *buffer) {
+  uint32_t limbs[FIXED_LIMBS] = {0};
+  int n = e2 / 32;
+  int bit = e2 % 32;
+  uint64_t lo = m << bit;
+  limbs[n++] = (uint32_t) lo;
+  limbs[n++] = (uint32_t) (lo >> 32);
+  limbs[n++] = bit ? (uint32_t) (m >> (64 - bit)) : 0;
+  while (limbs[n - 1] == 0) {
+    n--;
+  }
+
+  // divide out groups of 9 digits from the least significant end
+  char temp[FIXED_INT_DIGITS + 9];
+  char *ptr = temp + sizeof(temp);
+  while (n > 0) {
+    uint64_t rem = 0;
+    for (int i = n - 1; i >= 0; i--) {
+      uint64_t cur = (rem << 32) | limbs[i];
+      limbs[i] = (uint32_t) (cur / 1000000000);
+      rem = cur % 1000000000;
+    }
+    while (n > 0 && limbs[n - 1] == 0) {
+      n--;
+    }
+
+    if (n > 0) {
+      for (int i = 0; i < 9; i++) {
+        *--ptr = (char) ('0' + rem % 10);
+        rem /= 10;
+      }
+    } else {
+      while (rem > 0) {
+        *--ptr = (char) ('0' + rem % 10);
+        rem /= 10;
+      }
+    }
+  }
+
+  size_t len = temp + sizeof(temp) - ptr;
+  memcpy(buffer, ptr, len);
+  return len;
+}
+
+// the part of a number after its last written digit, relative to half of that digit
+enum rest {
+  REST_ZERO,
+  REST_BELOW,
+  REST_HALF,
+  REST_ABOVE,
+};
+
+// Writes up to count digits of the fraction f / 2^k (k > 0) to the buffer and returns
+// the number of digits written. this is less than count when all remaining digits are
+// zero. rest is set to the class of the fraction that is left.
+static size_t fraction_to_dec(uint64_t f, int k, size_t count, char *buffer, enum rest *rest) {
+  size_t n = 0;
+  if (k <= 60) {
+    uint64_t mask = (1ull << k) - 1;
+    uint64_t half = 1ull << (k - 1);
+    while (n < count && f != 0) {
+      f *= 10;
+      buffer[n++] = (char) ('0' + (f >> k));
+      f &= mask;
+    }
+    *rest = f == 0 ? REST_ZERO : (f < half ? REST_BELOW : (f == half ? REST_HALF : REST_ABOVE));
+    return n;
+  }
+
+  // the fraction is scaled up to a whole number of limbs so that the digits carry out
+  // of the top limb. low limbs are skipped once they become zero.
+  uint32_t limbs[FIXED_LIMBS] = {0};
+  int len = (k + 31) / 32;
+  int shift = len * 32 - k;
+  uint64_t lo = f << shift;
+  limbs[0] = (uint32_t) lo;
+  limbs[1] = (uint32_t) (lo >> 32);
+  limbs[2] = shift ? (uint32_t) (f >> (64 - shift)) : 0;
+
+  int low = 0;
+  while (n < count && low < len) {
+    size_t r = min(count - n, 9);
+    uint64_t mul = pow10_u64[r];
+    uint64_t carry = 0;
+    for (int i = low; i < len; i++) {
+      uint64_t cur = limbs[i] * mul + carry;
+      limbs[i] = (uint32_t) cur;
+      carry = cur >> 32;
+    }
+
+    for (size_t i = r; i > 0; i--) {
+      buffer[n + i - 1] = (char) ('0' + carry % 10);
+      carry /= 10;
+    }
+    n += r;
+    while (low < len && limbs[low] == 0) {
+      low++;
+    }
+  }
+
+  uint32_t top = limbs[len - 1];
+  if (low == len) {
+    *rest = REST_ZERO;
+  } else if (top < 0x80000000u) {
+    *rest = REST_BELOW;
+  } else {
+    *rest = top == 0x80000000u && low == len - 1 ? REST_HALF : REST_ABOVE;
+  }
+  return n;
+}
+
+// Writes the integer digits of m * 2^e2 followed by up to frac_count digits of the
+// fraction to the buffer and returns the total number of digits. int_len is set to the
+// number of integer digits, which is 1 for values below one, and rest to the class of
+// the fraction that is left.
+static inline size_t double_to_digits(uint64_t m, int e2, size_t frac_count, char *buffer, size_t *int_len, enum rest *rest) {
+  uint64_t frac = 0;
+  int k = -e2;
+  if (e2 >= 0) {
+    *int_len = e2 <= 11 ? u64_to_dec(m << e2, buffer) : shifted_to_dec(m, e2, buffer);
+  } else if (k < 64) {
+    *int_len = u64_to_dec(m >> k, buffer);
+    frac = m & ((1ull << k) - 1);
+  } else {
+    buffer[0] = '0';
+    *int_len = 1;
+    frac = m;
+  }
+
+  if (frac == 0) {
+    *rest = REST_ZERO;
+    return *int_len;
+  }
+  return *int_len + fraction_to_dec(frac, k, frac_count, buffer + *int_len, rest);
+}
+
+// Returns the class of the digits followed by the given rest.
+static enum rest digits_rest(const char *digits, size_t len, enum rest rest) {
+  bool tail = rest != REST_ZERO;
+  for (size_t i = 1; i < len; i++) {
+    tail |= digits[i] != '0';
+  }
+  if (digits[0] == '5') {
+    return tail ? REST_ABOVE : REST_HALF;
+  } else if (digits[0] == '0') {
+    return tail ? REST_BELOW : REST_ZERO;
+  }
+  return digits[0] > '5' ? REST_ABOVE : REST_BELOW;
+}
+
+// Rounds the digits half to even given the class of what follows them. returns true
+// if the carry ran out of the digits, in which case they are all zero.
+static bool round_digits(char *digits, size_t len, enum rest rest) {
+  if (rest < REST_HALF || (rest == REST_HALF && !(digits[len - 1] & 1))) {
+    return false;
+  }
+  for (size_t i = len; i > 0; i--) {
+    if (digits[i - 1] != '9') {
+      digits[i - 1]++;
+      return false;
+    }
+    digits[i - 1] = '0';
+  }
+  return true;
+}
+
+// Writes the sign and the digits with the decimal exponent exp10 of the first digit in
+// fixed notation, with frac_len digits after the point. the digits must not go past the
+// last fraction digit and the buffer must have room for the integer part, which is
+// padded with zeros, and the point. the point and fraction are left out if point is false.
+static size_t write_fixed(fmt_buffer_t *buffer, fmt_spec_t *num_spec, bool is_negative, char *digits, size_t len,
+                          int exp10, size_t frac_len, bool point) {
+  size_t width = num_spec->width;
+  if (exp10 < 0) {
+    // the integer part is zero and the fraction starts with zeros
+    size_t lead = -exp10 - 1;
+    size_t after = point ? 1 + frac_len : 0;
+    num_spec->width = width > after ? width - after : 0;
+    size_t n = write_integer(buffer, num_spec, is_negative, &decimal_format, "0", 1);
+    if (point) {
+      n += fmtlib_buffer_write_char(buffer, '.');
+      n += fmtlib_buffer_fill(buffer, '0', lead);
+      n += fmtlib_buffer_write(buffer, digits, len);
+      n += fmtlib_buffer_fill(buffer, '0', frac_len - lead - len);
+    }
+    return n;
+  }
+
+  size_t int_len = exp10 + 1;
+  if (len < int_len) {
+    memset(digits + len, '0', int_len - len);
+    len = int_len;
+  }
+  if (!point) {
+    return write_integer(buffer, num_spec, is_negative, &decimal_format, digits, int_len);
+  }
+
+  // the point is moved into the digits so they are written at once
+  for (size_t i = len; i > int_len; i--) {
+    digits[i] = digits[i - 1];
+  }
+  digits[int_len] = '.';
+
+  size_t zeros = frac_len - (len - int_len);
+  num_spec->width = width > zeros ? width - zeros : 0;
+  size_t n = write_integer(buffer, num_spec, is_negative, &decimal_format, digits, len + 1);
+  if (zeros > 0) {
+    n += fmtlib_buffer_fill(buffer, '0', zeros);
+  }
+  return n;
+}
+
+// Writes the sign or special value for infinity and NaN.
+static size_t format_special(fmt_buffer_t *buffer, const fmt_spec_t *spec, union double_raw v) {
+  bool upper = spec->flags & FMT_FLAG_UPPER;
+  const char *str = v.frac == 0 ? (upper ? "INF" : "inf") : (upper ? "NAN" : "nan");
+  fmt_spec_t num_spec = *spec;
+  num_spec.precision = 0;
+  num_spec.flags &= ~(FMT_FLAG_ALT | FMT_FLAG_ZERO);
+  return write_integer(buffer, &num_spec, v.sign, &decimal_format, str, 3);
+}
+
+// Writes a floating point number in fixed notation to the buffer.
+// respects numeric flags. also supports the ALT flag for truncated
+// representations of whole numbers (e.g. 1.000000 -> 1).
+static size_t format_double(fmt_buffer_t *buffer, const fmt_spec_t *spec) {
+  union double_raw v = { .value = spec->value.double_value };
+  size_t prec = spec->precision > 0 ? spec->precision : PRECISION_DEFAULT;
+
+  // the sign and zero padding are written by write_integer, without a minimum
+  // number of digits or prefix
+  fmt_spec_t num_spec = *spec;
+  num_spec.precision = 0;
+  num_spec.flags &= ~FMT_FLAG_ALT;
+  if (v.exp == 0x7FF) {
+    return format_special(buffer, spec, v);
+  }
+
+  uint64_t m = v.exp == 0 ? v.frac : v.frac | (1ull << 52);
+  int e2 = v.exp == 0 ? -1074 : (int) v.exp - 1075;
+
+  // the digits start one byte in to leave room for a carry when rounding
+  char temp[1 + FIXED_INT_DIGITS + FIXED_FRAC_DIGITS + 9];
+  char *digits = temp + 1;
+  size_t int_len;
+  enum rest rest;
+  size_t len = double_to_digits(m, e2, min(prec, FIXED_FRAC_DIGITS + 9), digits, &int_len, &rest);
+  if (round_digits(digits, len, rest)) {
+    *--digits = '1';
+    int_len++;
+    len++;
+  }
+
+  // the only time we _dont_ want to write the decimal point and fraction is
+  // when the fraction is zero while the ALT flag is set.
+  bool point = true;
+  if (spec->flags & FMT_FLAG_ALT) {
+    size_t i = int_len;
+    while (i < len && digits[i] == '0') {
+      i++;
+    }
+    point = i < len;
+  }
+  return write_fixed(buffer, &num_spec, v.sign, digits, len, (int) int_len - 1, prec, point);
+}
+
+// MARK: Scientific doubles
+//
+// the 'e' type and the 'g' type with a precision use the same exact digits as the
+// fixed notation, rounded to a number of significant digits instead of a position.
 
-static const struct num_format binary_format = { .base = 2, .digits = "01", .prefix = "0b" };
-static const struct num_format octal_format = { .base = 8, .digits = "01234567", .prefix = "0o" };
-static const struct num_format decimal_format = { .base = 10, .digits = "0123456789", .prefix = "" };
-static const struct num_format hex_lower_format = { .base = 16, .digits = "0123456789abcdef", .prefix = "0x" };
-static const struct num_format hex_upper_format = { .base = 16, .digits = "0123456789ABCDEF", .prefix = "0X" };
+// Writes the exponent of a number in scientific notation (e.g. e+05) and returns its length.
+static size_t exponent_to_str(int exp10, bool upper, char *buffer) {
+  char *ptr = buffer;
+  *ptr++ = upper ? 'E' : 'e';
+  *ptr++ = exp10 < 0 ? '-' : '+';
+  exp10 = exp10 < 0 ? -exp10 : exp10;
+  if (exp10 >= 100) {
+    *ptr++ = (char) ('0' + exp10 / 100);
+    exp10 %= 100;
+  }
+  copy_fixed(ptr, DIGIT_PAIR(exp10), 2);
+  return ptr + 2 - buffer;
+}
 
-static const double pow10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+// Writes the first count significant digits of m * 2^e2 to the buffer, correctly rounded,
+// and sets exp10 to the decimal exponent of the first digit. returns the number of digits
+// written, which is less than count when the rest are zero. the buffer must have room for
+// FIXED_INT_DIGITS + FIXED_FRAC_DIGITS + 9 digits.
+static size_t double_to_precision(uint64_t m, int e2, size_t count, char *buffer, int *exp10) {
+  if (m == 0) {
+    buffer[0] = '0';
+    *exp10 = 0;
+    return 1;
+  }
 
-static inline size_t u64_to_str(uint64_t value, char *buffer, const struct num_format *format) {
-  size_t n = 0;
-  int base = format->base;
-  const char *digits = format->digits;
-  if (value == 0) {
-    buffer[n++] = '0';
-    return n;
+  // the exponent estimated from the bit length is at most one below the actual one, in
+  // which case one extra digit is generated and rounded away
+  int b = e2 + 63 - __builtin_clzll(m);
+  int est = (b * 1262611) >> 22;
+  size_t frac_count = (int) count - 1 - est > 0 ? count - 1 - est : 0;
+
+  size_t int_len;
+  enum rest rest;
+  size_t len = double_to_digits(m, e2, min(frac_count, FIXED_FRAC_DIGITS + 9), buffer, &int_len, &rest);
+  size_t zeros = 0;
+  while (buffer[zeros] == '0') {
+    zeros++;
+  }
+  len -= zeros;
+  memmove(buffer, buffer + zeros, len);
+  *exp10 = (int) int_len - 1 - (int) zeros;
+
+  if (len > count) {
+    rest = digits_rest(buffer + count, len - count, rest);
+    len = count;
   }
+  if (round_digits(buffer, len, rest)) {
+    buffer[0] = '1';
+    (*exp10)++;
+  }
+  return len;
+}
 
-  while (value > 0) {
-    buffer[n++] = digits[value % base];
-    value /= base;
+// Writes the sign and the digits in scientific notation with frac_len digits after the
+// point, padded with zeros. the point and fraction are left out if point is false. the
+// buffer must have room for the point and the exponent after the digits.
+static size_t write_scientific(fmt_buffer_t *buffer, fmt_spec_t *num_spec, bool is_negative, char *digits,
+                               size_t len, int exp10, size_t frac_len, bool point) {
+  char exp[8];
+  size_t exp_len = exponent_to_str(exp10, num_spec->flags & FMT_FLAG_UPPER, exp);
+  size_t zeros = point ? frac_len - (len - 1) : 0;
+  size_t end = 1;
+  if (point) {
+    for (size_t i = len; i > 1; i--) {
+      digits[i] = digits[i - 1];
+    }
+    digits[1] = '.';
+    end = len + 1;
   }
 
-  // reverse buffer
-  for (size_t i = 0; i < n / 2; i++) {
-    char tmp = buffer[i];
-    buffer[i] = buffer[n - i - 1];
-    buffer[n - i - 1] = tmp;
+  // the exponent is written with the digits unless zeros come in between
+  size_t width = num_spec->width;
+  if (zeros == 0) {
+    for (size_t i = 0; i < exp_len; i++) {
+      digits[end++] = exp[i];
+    }
+    return write_integer(buffer, num_spec, is_negative, &decimal_format, digits, end);
   }
+
+  num_spec->width = width > zeros + exp_len ? width - zeros - exp_len : 0;
+  size_t n = write_integer(buffer, num_spec, is_negative, &decimal_format, digits, end);
+  n += fmtlib_buffer_fill(buffer, '0', zeros);
+  n += fmtlib_buffer_write(buffer, exp, exp_len);
   return n;
 }
 
-// Writes a signed or unsigned number to the buffer using the given format.
-static inline size_t format_integer(fmt_buffer_t *buffer, const fmt_spec_t *spec, bool is_signed, const struct num_format *format) {
-  int width = min(max(spec->width, 0), FMTLIB_MAX_WIDTH);
-  size_t n = 0;
-  uint64_t v;
-  bool is_negative = false;
-  if (is_signed) {
-    int64_t i = (int64_t) spec->value.uint64_value;
-    if (i < 0) {
-      v = -i;
-      is_negative = true;
-    } else {
-      v = i;
+// Writes a floating point number in scientific notation to the buffer with the
+// precision as the number of digits after the point (e.g. 1.234560e+05). like the
+// fixed notation the ALT flag leaves out a fraction which is zero.
+static size_t format_exp(fmt_buffer_t *buffer, const fmt_spec_t *spec) {
+  union double_raw v = { .value = spec->value.double_value };
+  size_t prec = spec->precision > 0 ? spec->precision : PRECISION_DEFAULT;
+
+  fmt_spec_t num_spec = *spec;
+  num_spec.precision = 0;
+  num_spec.flags &= ~FMT_FLAG_ALT;
+  if (v.exp == 0x7FF) {
+    return format_special(buffer, spec, v);
+  }
+
+  uint64_t m = v.exp == 0 ? v.frac : v.frac | (1ull << 52);
+  int e2 = v.exp == 0 ? -1074 : (int) v.exp - 1075;
+  char digits[FIXED_INT_DIGITS + FIXED_FRAC_DIGITS + 9];
+  int exp10;
+  size_t len = double_to_precision(m, e2, prec + 1, digits, &exp10);
+
+  bool point = true;
+  if (spec->flags & FMT_FLAG_ALT) {
+    size_t i = 1;
+    while (i < len && digits[i] == '0') {
+      i++;
     }
-  } else {
-    v = spec->value.uint64_value;
+    point = i < len;
   }
+  return write_scientific(buffer, &num_spec, v.sign, digits, len, exp10, prec, point);
+}
 
-  // write sign or space to buffer
-  if (is_negative) {
-    n += fmtlib_buffer_write_char(buffer, '-');
-  } else if (spec->flags & FMT_FLAG_SIGN) {
-    n += fmtlib_buffer_write_char(buffer, '+');
-  } else if (spec->flags & FMT_FLAG_SPACE) {
-    n += fmtlib_buffer_write_char(buffer, ' ');
+// Writes a floating point number with the precision as the number of significant
+// digits like printf %g. it is written in scientific notation if the exponent is
+// below -4 or not below the precision and in fixed notation otherwise. trailing
+// zeros are removed unless the ALT flag is set.
+static size_t format_general(fmt_buffer_t *buffer, const fmt_spec_t *spec) {
+  union double_raw v = { .value = spec->value.double_value };
+  size_t prec = spec->precision;
+  bool alt = spec->flags & FMT_FLAG_ALT;
+
+  fmt_spec_t num_spec = *spec;
+  num_spec.precision = 0;
+  num_spec.flags &= ~FMT_FLAG_ALT;
+  if (v.exp == 0x7FF) {
+    return format_special(buffer, spec, v);
   }
 
-  // write prefix for alternate form (e.g. 0x) to buffer
-  if (spec->flags & FMT_FLAG_ALT) {
-    const char *ptr = format->prefix;
-    while (*ptr) {
-      n += fmtlib_buffer_write_char(buffer, *ptr++);
+  uint64_t m = v.exp == 0 ? v.frac : v.frac | (1ull << 52);
+  int e2 = v.exp == 0 ? -1074 : (int) v.exp - 1075;
+  char digits[FIXED_INT_DIGITS + FIXED_FRAC_DIGITS + 9];
+  int exp10;
+  size_t len = double_to_precision(m, e2, prec, digits, &exp10);
+  if (!alt) {
+    while (len > 1 && digits[len - 1] == '0') {
+      len--;
     }
   }
 
-  // write digits to an intermediate buffer so we can calculate the
-  // length of the number and apply precision and padding accordingly
-  char temp[TEMP_BUFFER_SIZE];
-  size_t len = u64_to_str(v, temp, format);
+  if (exp10 < -4 || exp10 >= (int) prec) {
+    size_t frac_len = alt ? prec - 1 : len - 1;
+    return write_scientific(buffer, &num_spec, v.sign, digits, len, exp10, frac_len, alt || frac_len > 0);
+  }
 
-  // pad with leading zeros to reach specified precision
-  if ((size_t)spec->precision > len) {
-    size_t padding = spec->precision - len;
-    for (size_t i = 0; i < padding; i++) {
-      n += fmtlib_buffer_write_char(buffer, '0');
+  size_t frac_len = prec - 1 - exp10;
+  if (!alt) {
+    frac_len = (int) len - 1 - exp10 > 0 ? len - 1 - exp10 : 0;
+  }
+  return write_fixed(buffer, &num_spec, v.sign, digits, len, exp10, frac_len, alt || frac_len > 0);
+}
+
+// MARK: Hexadecimal doubles
+//
+// the 'a' type writes the bits of the significand directly as hex digits, which is
+// exact and reads back as the same value without any decimal conversion.
+
+// Writes a floating point number in hexadecimal scientific notation like printf %a
+// (e.g. 0x1.8p+1). without a precision all digits of the significand up to the last
+// nonzero one are written, otherwise it is rounded to that many digits after the point.
+// like the other notations the ALT flag leaves out a fraction which is zero.
+static size_t format_hexfloat(fmt_buffer_t *buffer, const fmt_spec_t *spec) {
+  union double_raw v = { .value = spec->value.double_value };
+  const struct num_format *format = spec->flags & FMT_FLAG_UPPER ? &hex_upper_format : &hex_lower_format;
+  if (v.exp == 0x7FF) {
+    return format_special(buffer, spec, v);
+  }
+
+  // the prefix is written by write_integer so that zero padding goes after it
+  fmt_spec_t num_spec = *spec;
+  num_spec.precision = 0;
+  num_spec.flags |= FMT_FLAG_ALT;
+
+  // the leading digit is 1 for normal numbers and 0 for subnormals and zero
+  uint64_t frac = v.frac;
+  uint64_t lead = v.exp != 0;
+  int exp2 = v.exp != 0 ? (int) v.exp - 1023 : (frac != 0 ? -1022 : 0);
+  size_t prec = spec->precision;
+  size_t len = 13;
+  if (prec == 0 && frac == 0) {
+    len = 0;
+  } else if (prec == 0) {
+    // leave out the trailing zero digits
+    size_t zeros = __builtin_ctzll(frac) / 4;
+    frac >>= 4 * zeros;
+    len -= zeros;
+  } else if (prec < 13) {
+    // round half to even on the dropped digits, a carry goes into the leading digit
+    int drop = 4 * (13 - (int) prec);
+    uint64_t rest = frac & ((1ull << drop) - 1);
+    uint64_t half = 1ull << (drop - 1);
+    frac >>= drop;
+    if (rest > half || (rest == half && (frac & 1))) {
+      frac++;
     }
+    lead += frac >> (4 * prec);
+    frac &= (1ull << (4 * prec)) - 1;
+    len = prec;
   }
 
-  // left-pad number with zeros to reach specified width
-  if (spec->flags & FMT_FLAG_ZERO && (size_t)width > len + n) {
-    // normally padding is handled outside of this function and is applied to the
-    // entire number including the sign or prefix. however, when the zero flag is
-    // set, the zero padding is applied to the number only and keeps the sign or
-    // prefix in front of the number.
-    if ((size_t)width > len + n) {
-      size_t padding = width - len - n;
-      for (size_t i = 0; i < padding; i++) {
-        n += fmtlib_buffer_write_char(buffer, '0');
-      }
+  bool point = prec > 0 ? !(spec->flags & FMT_FLAG_ALT && frac == 0) : len > 0;
+  char digits[2 + 13 + 8];
+  size_t end = 1;
+  digits[0] = format->digits[lead];
+  if (point) {
+    digits[1] = '.';
+    end = 2 + u64_to_pow2_len(frac, digits + 2, len, format);
+  }
+
+  char exp[8];
+  size_t exp_len = 2;
+  exp[0] = spec->flags & FMT_FLAG_UPPER ? 'P' : 'p';
+  exp[1] = exp2 < 0 ? '-' : '+';
+  exp_len += u64_to_str(exp2 < 0 ? -exp2 : exp2, exp + 2, &decimal_format);
+
+  // the exponent is written with the digits unless zeros come in between
+  size_t zeros = point && prec > 13 ? prec - 13 : 0;
+  size_t width = num_spec.width;
+  if (zeros == 0) {
+    for (size_t i = 0; i < exp_len; i++) {
+      digits[end++] = exp[i];
     }
+    return write_integer(buffer, &num_spec, v.sign, format, digits, end);
   }
 
-  // finally write the number to the buffer
-  n += fmtlib_buffer_write(buffer, temp, len);
+  num_spec.width = width > zeros + exp_len ? width - zeros - exp_len : 0;
+  size_t n = write_integer(buffer, &num_spec, v.sign, format, digits, end);
+  n += fmtlib_buffer_fill(buffer, '0', zeros);
+  n += fmtlib_buffer_write(buffer, exp, exp_len);
   return n;
 }
 
-static size_t format_signed(fmt_buffer_t *buffer, const fmt_spec_t *spec) {
-  return format_integer(buffer, spec, true, &decimal_format);
-}
+// MARK: Shortest doubles
+//
+// doubles are written with the fewest digits that read back as the same value by the
+// Schubfach algorithm of R. Giulietti. the value and the bounds of the interval which
+// rounds to it are scaled by a power of ten from a table so that at most two candidates
+// are left, and the shortest candidate inside the interval is picked.
 
-static size_t format_unsigned(fmt_buffer_t *buffer, const fmt_spec_t *spec) {
-  return format_integer(buffer, spec, false, &decimal_format);
+#define POW10_MIN_EXP (-292)
+
+// the powers of ten from 10^-292 to 10^326 as 128-bit significands. 10^k is stored as
+// ceil(10^k / 2^e) where e is chosen so that the significand has exactly 128 bits.
+static const struct pow10_u128 {
+  uint64_t hi;
+  uint64_t lo;
+} pow10_u128[619] = {
+  { 0xff77b1fcbebcdc4full, 0x25e8e89c13bb0f7bull }, { 0x9faacf3df73609b1ull, 0x77b191618c54e9adull },
+  { 0xc795830d75038c1dull, 0xd59df5b9ef6a2418ull }, { 0xf97ae3d0d2446f25ull, 0x4b0573286b44ad1eull },
+  { 0x9becce62836ac577ull, 0x4ee367f9430aec33ull }, { 0xc2e801fb244576d5ull, 0x229c41f793cda740ull },
+  { 0xf3a20279ed56d48aull, 0x6b43527578c11110ull }, { 0x9845418c345644d6ull, 0x830a13896b78aaaaull },
+  { 0xbe5691ef416bd60cull, 0x23cc986bc656d554ull }, { 0xedec366b11c6cb8full, 0x2cbfbe86b7ec8aa9ull },
+  { 0x94b3a202eb1c3f39ull, 0x7bf7d71432f3d6aaull }, { 0xb9e08a83a5e34f07ull, 0xdaf5ccd93fb0cc54ull },
+  { 0xe858ad248f5c22c9ull, 0xd1b3400f8f9cff69ull }, { 0x91376c36d99995beull, 0x23100809b9c21fa2ull },
+  { 0xb58547448ffffb2dull, 0xabd40a0c2832a78bull }, { 0xe2e69915b3fff9f9ull, 0x16c90c8f323f516dull },
+  { 0x8dd01fad907ffc3bull, 0xae3da7d97f6792e4ull }, { 0xb1442798f49ffb4aull, 0x99cd11cfdf41779dull },
+  { 0xdd95317f31c7fa1dull, 0x40405643d711d584ull }, { 0x8a7d3eef7f1cfc52ull, 0x482835ea666b2573ull },
+  { 0xad1c8eab5ee43b66ull, 0xda3243650005eed0ull }, { 0xd863b256369d4a40ull, 0x90bed43e40076a83ull },
+  { 0x873e4f75e2224e68ull, 0x5a7744a6e804a292ull }, { 0xa90de3535aaae202ull, 0x711515d0a205cb37ull },
+  { 0xd3515c2831559a83ull, 0x0d5a5b44ca873e04ull }, { 0x8412d9991ed58091ull, 0xe858790afe9486c3ull },
+  { 0xa5178fff668ae0b6ull, 0x626e974dbe39a873ull }, { 0xce5d73ff402d98e3ull, 0xfb0a3d212dc81290ull },
+  { 0x80fa687f881c7f8eull, 0x7ce66634bc9d0b9aull }, { 0xa139029f6a239f72ull, 0x1c1fffc1ebc44e81ull },
+  { 0xc987434744ac874eull, 0xa327ffb266b56221ull }, { 0xfbe9141915d7a922ull, 0x4bf1ff9f0062baa9ull },
+  { 0x9d71ac8fada6c9b5ull, 0x6f773fc3603db4aaull }, { 0xc4ce17b399107c22ull, 0xcb550fb4384d21d4ull },
+  { 0xf6019da07f549b2bull, 0x7e2a53a146606a49ull }, { 0x99c102844f94e0fbull, 0x2eda7444cbfc426eull },
+  { 0xc0314325637a1939ull, 0xfa911155fefb5309ull }, { 0xf03d93eebc589f88ull, 0x793555ab7eba27cbull },
+  { 0x96267c7535b763b5ull, 0x4bc1558b2f3458dfull }, { 0xbbb01b9283253ca2ull, 0x9eb1aaedfb016f17ull },
+  { 0xea9c227723ee8bcbull, 0x465e15a979c1caddull }, { 0x92a1958a7675175full, 0x0bfacd89ec191ecaull },
+  { 0xb749faed14125d36ull, 0xcef980ec671f667cull }, { 0xe51c79a85916f484ull, 0x82b7e12780e7401bull },
+  { 0x8f31cc0937ae58d2ull, 0xd1b2ecb8b0908811ull }, { 0xb2fe3f0b8599ef07ull, 0x861fa7e6dcb4aa16ull },
+  { 0xdfbdcece67006ac9ull, 0x67a791e093e1d49bull }, { 0x8bd6a141006042bdull, 0xe0c8bb2c5c6d24e1ull },
+  { 0xaecc49914078536dull, 0x58fae9f773886e19ull }, { 0xda7f5bf590966848ull, 0xaf39a475506a899full },
+  { 0x888f99797a5e012dull, 0x6d8406c952429604ull }, { 0xaab37fd7d8f58178ull, 0xc8e5087ba6d33b84ull },
+  { 0xd5605fcdcf32e1d6ull, 0xfb1e4a9a90880a65ull }, { 0x855c3be0a17fcd26ull, 0x5cf2eea09a550680ull },
+  { 0xa6b34ad8c9dfc06full, 0xf42faa48c0ea481full }, { 0xd0601d8efc57b08bull, 0xf13b94daf124da27ull },
+  { 0x823c12795db6ce57ull, 0x76c53d08d6b70859ull }, { 0xa2cb1717b52481edull, 0x54768c4b0c64ca6full },
+  { 0xcb7ddcdda26da268ull, 0xa9942f5dcf7dfd0aull }, { 0xfe5d54150b090b02ull, 0xd3f93b35435d7c4dull },
+  { 0x9efa548d26e5a6e1ull, 0xc47bc5014a1a6db0ull }, { 0xc6b8e9b0709f109aull, 0x359ab6419ca1091cull },
+  { 0xf867241c8cc6d4c0ull, 0xc30163d203c94b63ull }, { 0x9b407691d7fc44f8ull, 0x79e0de63425dcf1eull },
+  { 0xc21094364dfb5636ull, 0x985915fc12f542e5ull }, { 0xf294b943e17a2bc4ull, 0x3e6f5b7b17b2939eull },
+  { 0x979cf3ca6cec5b5aull, 0xa705992ceecf9c43ull }, { 0xbd8430bd08277231ull, 0x50c6ff782a838354ull },
+  { 0xece53cec4a314ebdull, 0xa4f8bf5635246429ull }, { 0x940f4613ae5ed136ull, 0x871b7795e136be9aull },
+  { 0xb913179899f68584ull, 0x28e2557b59846e40ull }, { 0xe757dd7ec07426e5ull, 0x331aeada2fe589d0ull },
+  { 0x9096ea6f3848984full, 0x3ff0d2c85def7622ull }, { 0xb4bca50b065abe63ull, 0x0fed077a756b53aaull },
+  { 0xe1ebce4dc7f16dfbull, 0xd3e8495912c62895ull }, { 0x8d3360f09cf6e4bdull, 0x64712dd7abbbd95dull },
+  { 0xb080392cc4349decull, 0xbd8d794d96aacfb4ull }, { 0xdca04777f541c567ull, 0xecf0d7a0fc5583a1ull },
+  { 0x89e42caaf9491b60ull, 0xf41686c49db57245ull }, { 0xac5d37d5b79b6239ull, 0x311c2875c522ced6ull },
+  { 0xd77485cb25823ac7ull, 0x7d633293366b828cull }, { 0x86a8d39ef77164bcull, 0xae5dff9c02033198ull },
+  { 0xa8530886b54dbdebull, 0xd9f57f830283fdfdull }, { 0xd267caa862a12d66ull, 0xd072df63c324fd7cull },
+  { 0x8380dea93da4bc60ull, 0x4247cb9e59f71e6eull }, { 0xa46116538d0deb78ull, 0x52d9be85f074e609ull },
+  { 0xcd795be870516656ull, 0x67902e276c921f8cull }, { 0x806bd9714632dff6ull, 0x00ba1cd8a3db53b7ull },
+  { 0xa086cfcd97bf97f3ull, 0x80e8a40eccd228a5ull }, { 0xc8a883c0fdaf7df0ull, 0x6122cd128006b2ceull },
+  { 0xfad2a4b13d1b5d6cull, 0x796b805720085f82ull }, { 0x9cc3a6eec6311a63ull, 0xcbe3303674053bb1ull },
+  { 0xc3f490aa77bd60fcull, 0xbedbfc4411068a9dull }, { 0xf4f1b4d515acb93bull, 0xee92fb5515482d45ull },
+  { 0x991711052d8bf3c5ull, 0x751bdd152d4d1c4bull }, { 0xbf5cd54678eef0b6ull, 0xd262d45a78a0635eull },
+  { 0xef340a98172aace4ull, 0x86fb897116c87c35ull }, { 0x9580869f0e7aac0eull, 0xd45d35e6ae3d4da1ull },
+  { 0xbae0a846d2195712ull, 0x8974836059cca10aull }, { 0xe998d258869facd7ull, 0x2bd1a438703fc94cull },
+  { 0x91ff83775423cc06ull, 0x7b6306a34627ddd0ull }, { 0xb67f6455292cbf08ull, 0x1a3bc84c17b1d543ull },
+  { 0xe41f3d6a7377eecaull, 0x20caba5f1d9e4a94ull }, { 0x8e938662882af53eull, 0x547eb47b7282ee9dull },
+  { 0xb23867fb2a35b28dull, 0xe99e619a4f23aa44ull }, { 0xdec681f9f4c31f31ull, 0x6405fa00e2ec94d5ull },
+  { 0x8b3c113c38f9f37eull, 0xde83bc408dd3dd05ull }, { 0xae0b158b4738705eull, 0x9624ab50b148d446ull },
+  { 0xd98ddaee19068c76ull, 0x3badd624dd9b0958ull }, { 0x87f8a8d4cfa417c9ull, 0xe54ca5d70a80e5d7ull },
+  { 0xa9f6d30a038d1dbcull, 0x5e9fcf4ccd211f4dull }, { 0xd47487cc8470652bull, 0x7647c32000696720ull },
+  { 0x84c8d4dfd2c63f3bull, 0x29ecd9f40041e074ull }, { 0xa5fb0a17c777cf09ull, 0xf468107100525891ull },
+  { 0xcf79cc9db955c2ccull, 0x7182148d4066eeb5ull }, { 0x81ac1fe293d599bfull, 0xc6f14cd848405531ull },
+  { 0xa21727db38cb002full, 0xb8ada00e5a506a7dull }, { 0xca9cf1d206fdc03bull, 0xa6d90811f0e4851dull },
+  { 0xfd442e4688bd304aull, 0x908f4a166d1da664ull }, { 0x9e4a9cec15763e2eull, 0x9a598e4e043287ffull },
+  { 0xc5dd44271ad3cdbaull, 0x40eff1e1853f29feull }, { 0xf7549530e188c128ull, 0xd12bee59e68ef47dull },
+  { 0x9a94dd3e8cf578b9ull, 0x82bb74f8301958cfull }, { 0xc13a148e3032d6e7ull, 0xe36a52363c1faf02ull },
+  { 0xf18899b1bc3f8ca1ull, 0xdc44e6c3cb279ac2ull }, { 0x96f5600f15a7b7e5ull, 0x29ab103a5ef8c0baull },
+  { 0xbcb2b812db11a5deull, 0x7415d448f6b6f0e8ull }, { 0xebdf661791d60f56ull, 0x111b495b3464ad22ull },
+  { 0x936b9fcebb25c995ull, 0xcab10dd900beec35ull }, { 0xb84687c269ef3bfbull, 0x3d5d514f40eea743ull },
+  { 0xe65829b3046b0afaull, 0x0cb4a5a3112a5113ull }, { 0x8ff71a0fe2c2e6dcull, 0x47f0e785eaba72acull },
+  { 0xb3f4e093db73a093ull, 0x59ed216765690f57ull }, { 0xe0f218b8d25088b8ull, 0x306869c13ec3532dull },
+  { 0x8c974f7383725573ull, 0x1e414218c73a13fcull }, { 0xafbd2350644eeacfull, 0xe5d1929ef90898fbull },
+  { 0xdbac6c247d62a583ull, 0xdf45f746b74abf3aull }, { 0x894bc396ce5da772ull, 0x6b8bba8c328eb784ull },
+  { 0xab9eb47c81f5114full, 0x066ea92f3f326565ull }, { 0xd686619ba27255a2ull, 0xc80a537b0efefebeull },
+  { 0x8613fd0145877585ull, 0xbd06742ce95f5f37ull }, { 0xa798fc4196e952e7ull, 0x2c48113823b73705ull },
+  { 0xd17f3b51fca3a7a0ull, 0xf75a15862ca504c6ull }, { 0x82ef85133de648c4ull, 0x9a984d73dbe722fcull },
+  { 0xa3ab66580d5fdaf5ull, 0xc13e60d0d2e0ebbbull }, { 0xcc963fee10b7d1b3ull, 0x318df905079926a9ull },
+  { 0xffbbcfe994e5c61full, 0xfdf17746497f7053ull }, { 0x9fd561f1fd0f9bd3ull, 0xfeb6ea8bedefa634ull },
+  { 0xc7caba6e7c5382c8ull, 0xfe64a52ee96b8fc1ull }, { 0xf9bd690a1b68637bull, 0x3dfdce7aa3c673b1ull },
+  { 0x9c1661a651213e2dull, 0x06bea10ca65c084full }, { 0xc31bfa0fe5698db8ull, 0x486e494fcff30a63ull },
+  { 0xf3e2f893dec3f126ull, 0x5a89dba3c3efccfbull }, { 0x986ddb5c6b3a76b7ull, 0xf89629465a75e01dull },
+  { 0xbe89523386091465ull, 0xf6bbb397f1135824ull }, { 0xee2ba6c0678b597full, 0x746aa07ded582e2dull },
+  { 0x94db483840b717efull, 0xa8c2a44eb4571cddull }, { 0xba121a4650e4ddebull, 0x92f34d62616ce414ull },
+  { 0xe896a0d7e51e1566ull, 0x77b020baf9c81d18ull }, { 0x915e2486ef32cd60ull, 0x0ace1474dc1d122full },
+  { 0xb5b5ada8aaff80b8ull, 0x0d819992132456bbull }, { 0xe3231912d5bf60e6ull, 0x10e1fff697ed6c6aull },
+  { 0x8df5efabc5979c8full, 0xca8d3ffa1ef463c2ull }, { 0xb1736b96b6fd83b3ull, 0xbd308ff8a6b17cb3ull },
+  { 0xddd0467c64bce4a0ull, 0xac7cb3f6d05ddbdfull }, { 0x8aa22c0dbef60ee4ull, 0x6bcdf07a423aa96cull },
+  { 0xad4ab7112eb3929dull, 0x86c16c98d2c953c7ull }, { 0xd89d64d57a607744ull, 0xe871c7bf077ba8b8ull },
+  { 0x87625f056c7c4a8bull, 0x11471cd764ad4973ull }, { 0xa93af6c6c79b5d2dull, 0xd598e40d3dd89bd0ull },
+  { 0xd389b47879823479ull, 0x4aff1d108d4ec2c4ull }, { 0x843610cb4bf160cbull, 0xcedf722a585139bbull },
+  { 0xa54394fe1eedb8feull, 0xc2974eb4ee658829ull }, { 0xce947a3da6a9273eull, 0x733d226229feea33ull },
+  { 0x811ccc668829b887ull, 0x0806357d5a3f5260ull }, { 0xa163ff802a3426a8ull, 0xca07c2dcb0cf26f8ull },
+  { 0xc9bcff6034c13052ull, 0xfc89b393dd02f0b6ull }, { 0xfc2c3f3841f17c67ull, 0xbbac2078d443ace3ull },
+  { 0x9d9ba7832936edc0ull, 0xd54b944b84aa4c0eull }, { 0xc5029163f384a931ull, 0x0a9e795e65d4df12ull },
+  { 0xf64335bcf065d37dull, 0x4d4617b5ff4a16d6ull }, { 0x99ea0196163fa42eull, 0x504bced1bf8e4e46ull },
+  { 0xc06481fb9bcf8d39ull, 0xe45ec2862f71e1d7ull }, { 0xf07da27a82c37088ull, 0x5d767327bb4e5a4dull },
+  { 0x964e858c91ba2655ull, 0x3a6a07f8d510f870ull }, { 0xbbe226efb628afeaull, 0x890489f70a55368cull },
+  { 0xeadab0aba3b2dbe5ull, 0x2b45ac74ccea842full }, { 0x92c8ae6b464fc96full, 0x3b0b8bc90012929eull },
+  { 0xb77ada0617e3bbcbull, 0x09ce6ebb40173745ull }, { 0xe55990879ddcaabdull, 0xcc420a6a101d0516ull },
+  { 0x8f57fa54c2a9eab6ull, 0x9fa946824a12232eull }, { 0xb32df8e9f3546564ull, 0x47939822dc96abfaull },
+  { 0xdff9772470297ebdull, 0x59787e2b93bc56f8ull }, { 0x8bfbea76c619ef36ull, 0x57eb4edb3c55b65bull },
+  { 0xaefae51477a06b03ull, 0xede622920b6b23f2ull }, { 0xdab99e59958885c4ull, 0xe95fab368e45eceeull },
+  { 0x88b402f7fd75539bull, 0x11dbcb0218ebb415ull }, { 0xaae103b5fcd2a881ull, 0xd652bdc29f26a11aull },
+  { 0xd59944a37c0752a2ull, 0x4be76d3346f04960ull }, { 0x857fcae62d8493a5ull, 0x6f70a4400c562ddcull },
+  { 0xa6dfbd9fb8e5b88eull, 0xcb4ccd500f6bb953ull }, { 0xd097ad07a71f26b2ull, 0x7e2000a41346a7a8ull },
+  { 0x825ecc24c873782full, 0x8ed400668c0c28c9ull }, { 0xa2f67f2dfa90563bull, 0x728900802f0f32fbull },
+  { 0xcbb41ef979346bcaull, 0x4f2b40a03ad2ffbaull }, { 0xfea126b7d78186bcull, 0xe2f610c84987bfa9ull },
+  { 0x9f24b832e6b0f436ull, 0x0dd9ca7d2df4d7caull }, { 0xc6ede63fa05d3143ull, 0x91503d1c79720dbcull },
+  { 0xf8a95fcf88747d94ull, 0x75a44c6397ce912bull }, { 0x9b69dbe1b548ce7cull, 0xc986afbe3ee11abbull },
+  { 0xc24452da229b021bull, 0xfbe85badce996169ull }, { 0xf2d56790ab41c2a2ull, 0xfae27299423fb9c4ull },
+  { 0x97c560ba6b0919a5ull, 0xdccd879fc967d41bull }, { 0xbdb6b8e905cb600full, 0x5400e987bbc1c921ull },
+  { 0xed246723473e3813ull, 0x290123e9aab23b69ull }, { 0x9436c0760c86e30bull, 0xf9a0b6720aaf6522ull },
+  { 0xb94470938fa89bceull, 0xf808e40e8d5b3e6aull }, { 0xe7958cb87392c2c2ull, 0xb60b1d1230b20e05ull },
+  { 0x90bd77f3483bb9b9ull, 0xb1c6f22b5e6f48c3ull }, { 0xb4ecd5f01a4aa828ull, 0x1e38aeb6360b1af4ull },
+  { 0xe2280b6c20dd5232ull, 0x25c6da63c38de1b1ull }, { 0x8d590723948a535full, 0x579c487e5a38ad0full },
+  { 0xb0af48ec79ace837ull, 0x2d835a9df0c6d852ull }, { 0xdcdb1b2798182244ull, 0xf8e431456cf88e66ull },
+  { 0x8a08f0f8bf0f156bull, 0x1b8e9ecb641b5900ull }, { 0xac8b2d36eed2dac5ull, 0xe272467e3d222f40ull },
+  { 0xd7adf884aa879177ull, 0x5b0ed81dcc6abb10ull }, { 0x86ccbb52ea94baeaull, 0x98e947129fc2b4eaull },
+  { 0xa87fea27a539e9a5ull, 0x3f2398d747b36225ull }, { 0xd29fe4b18e88640eull, 0x8eec7f0d19a03aaeull },
+  { 0x83a3eeeef9153e89ull, 0x1953cf68300424adull }, { 0xa48ceaaab75a8e2bull, 0x5fa8c3423c052dd8ull },
+  { 0xcdb02555653131b6ull, 0x3792f412cb06794eull }, { 0x808e17555f3ebf11ull, 0xe2bbd88bbee40bd1ull },
+  { 0xa0b19d2ab70e6ed6ull, 0x5b6aceaeae9d0ec5ull }, { 0xc8de047564d20a8bull, 0xf245825a5a445276ull },
+  { 0xfb158592be068d2eull, 0xeed6e2f0f0d56713ull }, { 0x9ced737bb6c4183dull, 0x55464dd69685606cull },
+  { 0xc428d05aa4751e4cull, 0xaa97e14c3c26b887ull }, { 0xf53304714d9265dfull, 0xd53dd99f4b3066a9ull },
+  { 0x993fe2c6d07b7fabull, 0xe546a8038efe402aull }, { 0xbf8fdb78849a5f96ull, 0xde98520472bdd034ull },
+  { 0xef73d256a5c0f77cull, 0x963e66858f6d4441ull }, { 0x95a8637627989aadull, 0xdde7001379a44aa9ull },
+  { 0xbb127c53b17ec159ull, 0x5560c018580d5d53ull }, { 0xe9d71b689dde71afull, 0xaab8f01e6e10b4a7ull },
+  { 0x9226712162ab070dull, 0xcab3961304ca70e9ull }, { 0xb6b00d69bb55c8d1ull, 0x3d607b97c5fd0d23ull },
+  { 0xe45c10c42a2b3b05ull, 0x8cb89a7db77c506bull }, { 0x8eb98a7a9a5b04e3ull, 0x77f3608e92adb243ull },
+  { 0xb267ed1940f1c61cull, 0x55f038b237591ed4ull }, { 0xdf01e85f912e37a3ull, 0x6b6c46dec52f6689ull },
+  { 0x8b61313bbabce2c6ull, 0x2323ac4b3b3da016ull }, { 0xae397d8aa96c1b77ull, 0xabec975e0a0d081bull },
+  { 0xd9c7dced53c72255ull, 0x96e7bd358c904a22ull }, { 0x881cea14545c7575ull, 0x7e50d64177da2e55ull },
+  { 0xaa242499697392d2ull, 0xdde50bd1d5d0b9eaull }, { 0xd4ad2dbfc3d07787ull, 0x955e4ec64b44e865ull },
+  { 0x84ec3c97da624ab4ull, 0xbd5af13bef0b113full }, { 0xa6274bbdd0fadd61ull, 0xecb1ad8aeacdd58full },
+  { 0xcfb11ead453994baull, 0x67de18eda5814af3ull }, { 0x81ceb32c4b43fcf4ull, 0x80eacf948770ced8ull },
+  { 0xa2425ff75e14fc31ull, 0xa1258379a94d028eull }, { 0xcad2f7f5359a3b3eull, 0x096ee45813a04331ull },
+  { 0xfd87b5f28300ca0dull, 0x8bca9d6e188853fdull }, { 0x9e74d1b791e07e48ull, 0x775ea264cf55347eull },
+  { 0xc612062576589ddaull, 0x95364afe032a819eull }, { 0xf79687aed3eec551ull, 0x3a83ddbd83f52205ull },
+  { 0x9abe14cd44753b52ull, 0xc4926a9672793543ull }, { 0xc16d9a0095928a27ull, 0x75b7053c0f178294ull },
+  { 0xf1c90080baf72cb1ull, 0x5324c68b12dd6339ull }, { 0x971da05074da7beeull, 0xd3f6fc16ebca5e04ull },
+  { 0xbce5086492111aeaull, 0x88f4bb1ca6bcf585ull }, { 0xec1e4a7db69561a5ull, 0x2b31e9e3d06c32e6ull },
+  { 0x9392ee8e921d5d07ull, 0x3aff322e62439fd0ull }, { 0xb877aa3236a4b449ull, 0x09befeb9fad487c3ull },
+  { 0xe69594bec44de15bull, 0x4c2ebe687989a9b4ull }, { 0x901d7cf73ab0acd9ull, 0x0f9d37014bf60a11ull },
+  { 0xb424dc35095cd80full, 0x538484c19ef38c95ull }, { 0xe12e13424bb40e13ull, 0x2865a5f206b06fbaull },
+  { 0x8cbccc096f5088cbull, 0xf93f87b7442e45d4ull }, { 0xafebff0bcb24aafeull, 0xf78f69a51539d749ull },
+  { 0xdbe6fecebdedd5beull, 0xb573440e5a884d1cull }, { 0x89705f4136b4a597ull, 0x31680a88f8953031ull },
+  { 0xabcc77118461cefcull, 0xfdc20d2b36ba7c3eull }, { 0xd6bf94d5e57a42bcull, 0x3d32907604691b4dull },
+  { 0x8637bd05af6c69b5ull, 0xa63f9a49c2c1b110ull }, { 0xa7c5ac471b478423ull, 0x0fcf80dc33721d54ull },
+  { 0xd1b71758e219652bull, 0xd3c36113404ea4a9ull }, { 0x83126e978d4fdf3bull, 0x645a1cac083126eaull },
+  { 0xa3d70a3d70a3d70aull, 0x3d70a3d70a3d70a4ull }, { 0xccccccccccccccccull, 0xcccccccccccccccdull },
+  { 0x8000000000000000ull, 0x0000000000000000ull }, { 0xa000000000000000ull, 0x0000000000000000ull },
+  { 0xc800000000000000ull, 0x0000000000000000ull }, { 0xfa00000000000000ull, 0x0000000000000000ull },
+  { 0x9c40000000000000ull, 0x0000000000000000ull }, { 0xc350000000000000ull, 0x0000000000000000ull },
+  { 0xf424000000000000ull, 0x0000000000000000ull }, { 0x9896800000000000ull, 0x0000000000000000ull },
+  { 0xbebc200000000000ull, 0x0000000000000000ull }, { 0xee6b280000000000ull, 0x0000000000000000ull },
+  { 0x9502f90000000000ull, 0x0000000000000000ull }, { 0xba43b74000000000ull, 0x0000000000000000ull },
+  { 0xe8d4a51000000000ull, 0x0000000000000000ull }, { 0x9184e72a00000000ull, 0x0000000000000000ull },
+  { 0xb5e620f480000000ull, 0x0000000000000000ull }, { 0xe35fa931a0000000ull, 0x0000000000000000ull },
+  { 0x8e1bc9bf04000000ull, 0x0000000000000000ull }, { 0xb1a2bc2ec5000000ull, 0x0000000000000000ull },
+  { 0xde0b6b3a76400000ull, 0x0000000000000000ull }, { 0x8ac7230489e80000ull, 0x0000000000000000ull },
+  { 0xad78ebc5ac620000ull, 0x0000000000000000ull }, { 0xd8d726b7177a8000ull, 0x0000000000000000ull },
+  { 0x878678326eac9000ull, 0x0000000000000000ull }, { 0xa968163f0a57b400ull, 0x0000000000000000ull },
+  { 0xd3c21bcecceda100ull, 0x0000000000000000ull }, { 0x84595161401484a0ull, 0x0000000000000000ull },
+  { 0xa56fa5b99019a5c8ull, 0x0000000000000000ull }, { 0xcecb8f27f4200f3aull, 0x0000000000000000ull },
+  { 0x813f3978f8940984ull, 0x4000000000000000ull }, { 0xa18f07d736b90be5ull, 0x5000000000000000ull },
+  { 0xc9f2c9cd04674edeull, 0xa400000000000000ull }, { 0xfc6f7c4045812296ull, 0x4d00000000000000ull },
+  { 0x9dc5ada82b70b59dull, 0xf020000000000000ull }, { 0xc5371912364ce305ull, 0x6c28000000000000ull },
+  { 0xf684df56c3e01bc6ull, 0xc732000000000000ull }, { 0x9a130b963a6c115cull, 0x3c7f400000000000ull },
+  { 0xc097ce7bc90715b3ull, 0x4b9f100000000000ull }, { 0xf0bdc21abb48db20ull, 0x1e86d40000000000ull },
+  { 0x96769950b50d88f4ull, 0x1314448000000000ull }, { 0xbc143fa4e250eb31ull, 0x17d955a000000000ull },
+  { 0xeb194f8e1ae525fdull, 0x5dcfab0800000000ull }, { 0x92efd1b8d0cf37beull, 0x5aa1cae500000000ull },
+  { 0xb7abc627050305adull, 0xf14a3d9e40000000ull }, { 0xe596b7b0c643c719ull, 0x6d9ccd05d0000000ull },
+  { 0x8f7e32ce7bea5c6full, 0xe4820023a2000000ull }, { 0xb35dbf821ae4f38bull, 0xdda2802c8a800000ull },
+  { 0xe0352f62a19e306eull, 0xd50b2037ad200000ull }, { 0x8c213d9da502de45ull, 0x4526f422cc340000ull },
+  { 0xaf298d050e4395d6ull, 0x9670b12b7f410000ull }, { 0xdaf3f04651d47b4cull, 0x3c0cdd765f114000ull },
+  { 0x88d8762bf324cd0full, 0xa5880a69fb6ac800ull }, { 0xab0e93b6efee0053ull, 0x8eea0d047a457a00ull },
+  { 0xd5d238a4abe98068ull, 0x72a4904598d6d880ull }, { 0x85a36366eb71f041ull, 0x47a6da2b7f864750ull },
+  { 0xa70c3c40a64e6c51ull, 0x999090b65f67d924ull }, { 0xd0cf4b50cfe20765ull, 0xfff4b4e3f741cf6dull },
+  { 0x82818f1281ed449full, 0xbff8f10e7a8921a5ull }, { 0xa321f2d7226895c7ull, 0xaff72d52192b6a0eull },
+  { 0xcbea6f8ceb02bb39ull, 0x9bf4f8a69f764491ull }, { 0xfee50b7025c36a08ull, 0x02f236d04753d5b5ull },
+  { 0x9f4f2726179a2245ull, 0x01d762422c946591ull }, { 0xc722f0ef9d80aad6ull, 0x424d3ad2b7b97ef6ull },
+  { 0xf8ebad2b84e0d58bull, 0xd2e0898765a7deb3ull }, { 0x9b934c3b330c8577ull, 0x63cc55f49f88eb30ull },
+  { 0xc2781f49ffcfa6d5ull, 0x3cbf6b71c76b25fcull }, { 0xf316271c7fc3908aull, 0x8bef464e3945ef7bull },
+  { 0x97edd871cfda3a56ull, 0x97758bf0e3cbb5adull }, { 0xbde94e8e43d0c8ecull, 0x3d52eeed1cbea318ull },
+  { 0xed63a231d4c4fb27ull, 0x4ca7aaa863ee4bdeull }, { 0x945e455f24fb1cf8ull, 0x8fe8caa93e74ef6bull },
+  { 0xb975d6b6ee39e436ull, 0xb3e2fd538e122b45ull }, { 0xe7d34c64a9c85d44ull, 0x60dbbca87196b617ull },
+  { 0x90e40fbeea1d3a4aull, 0xbc8955e946fe31ceull }, { 0xb51d13aea4a488ddull, 0x6babab6398bdbe42ull },
+  { 0xe264589a4dcdab14ull, 0xc696963c7eed2dd2ull }, { 0x8d7eb76070a08aecull, 0xfc1e1de5cf543ca3ull },
+  { 0xb0de65388cc8ada8ull, 0x3b25a55f43294bccull }, { 0xdd15fe86affad912ull, 0x49ef0eb713f39ebfull },
+  { 0x8a2dbf142dfcc7abull, 0x6e3569326c784338ull }, { 0xacb92ed9397bf996ull, 0x49c2c37f07965405ull },
+  { 0xd7e77a8f87daf7fbull, 0xdc33745ec97be907ull }, { 0x86f0ac99b4e8dafdull, 0x69a028bb3ded71a4ull },
+  { 0xa8acd7c0222311bcull, 0xc40832ea0d68ce0dull }, { 0xd2d80db02aabd62bull, 0xf50a3fa490c30191ull },
+  { 0x83c7088e1aab65dbull, 0x792667c6da79e0fbull }, { 0xa4b8cab1a1563f52ull, 0x577001b891185939ull },
+  { 0xcde6fd5e09abcf26ull, 0xed4c0226b55e6f87ull }, { 0x80b05e5ac60b6178ull, 0x544f8158315b05b5ull },
+  { 0xa0dc75f1778e39d6ull, 0x696361ae3db1c722ull }, { 0xc913936dd571c84cull, 0x03bc3a19cd1e38eaull },
+  { 0xfb5878494ace3a5full, 0x04ab48a04065c724ull }, { 0x9d174b2dcec0e47bull, 0x62eb0d64283f9c77ull },
+  { 0xc45d1df942711d9aull, 0x3ba5d0bd324f8395ull }, { 0xf5746577930d6500ull, 0xca8f44ec7ee3647aull },
+  { 0x9968bf6abbe85f20ull, 0x7e998b13cf4e1eccull }, { 0xbfc2ef456ae276e8ull, 0x9e3fedd8c321a67full },
+  { 0xefb3ab16c59b14a2ull, 0xc5cfe94ef3ea101full }, { 0x95d04aee3b80ece5ull, 0xbba1f1d158724a13ull },
+  { 0xbb445da9ca61281full, 0x2a8a6e45ae8edc98ull }, { 0xea1575143cf97226ull, 0xf52d09d71a3293beull },
+  { 0x924d692ca61be758ull, 0x593c2626705f9c57ull }, { 0xb6e0c377cfa2e12eull, 0x6f8b2fb00c77836dull },
+  { 0xe498f455c38b997aull, 0x0b6dfb9c0f956448ull }, { 0x8edf98b59a373fecull, 0x4724bd4189bd5eadull },
+  { 0xb2977ee300c50fe7ull, 0x58edec91ec2cb658ull }, { 0xdf3d5e9bc0f653e1ull, 0x2f2967b66737e3eeull },
+  { 0x8b865b215899f46cull, 0xbd79e0d20082ee75ull }, { 0xae67f1e9aec07187ull, 0xecd8590680a3aa12ull },
+  { 0xda01ee641a708de9ull, 0xe80e6f4820cc9496ull }, { 0x884134fe908658b2ull, 0x3109058d147fdcdeull },
+  { 0xaa51823e34a7eedeull, 0xbd4b46f0599fd416ull }, { 0xd4e5e2cdc1d1ea96ull, 0x6c9e18ac7007c91bull },
+  { 0x850fadc09923329eull, 0x03e2cf6bc604ddb1ull }, { 0xa6539930bf6bff45ull, 0x84db8346b786151dull },
+  { 0xcfe87f7cef46ff16ull, 0xe612641865679a64ull }, { 0x81f14fae158c5f6eull, 0x4fcb7e8f3f60c07full },
+  { 0xa26da3999aef7749ull, 0xe3be5e330f38f09eull }, { 0xcb090c8001ab551cull, 0x5cadf5bfd3072cc6ull },
+  { 0xfdcb4fa002162a63ull, 0x73d9732fc7c8f7f7ull }, { 0x9e9f11c4014dda7eull, 0x2867e7fddcdd9afbull },
+  { 0xc646d63501a1511dull, 0xb281e1fd541501b9ull }, { 0xf7d88bc24209a565ull, 0x1f225a7ca91a4227ull },
+  { 0x9ae757596946075full, 0x3375788de9b06959ull }, { 0xc1a12d2fc3978937ull, 0x0052d6b1641c83afull },
+  { 0xf209787bb47d6b84ull, 0xc0678c5dbd23a49bull }, { 0x9745eb4d50ce6332ull, 0xf840b7ba963646e1ull },
+  { 0xbd176620a501fbffull, 0xb650e5a93bc3d899ull }, { 0xec5d3fa8ce427affull, 0xa3e51f138ab4cebfull },
+  { 0x93ba47c980e98cdfull, 0xc66f336c36b10138ull }, { 0xb8a8d9bbe123f017ull, 0xb80b0047445d4185ull },
+  { 0xe6d3102ad96cec1dull, 0xa60dc059157491e6ull }, { 0x9043ea1ac7e41392ull, 0x87c89837ad68db30ull },
+  { 0xb454e4a179dd1877ull, 0x29babe4598c311fcull }, { 0xe16a1dc9d8545e94ull, 0xf4296dd6fef3d67bull },
+  { 0x8ce2529e2734bb1dull, 0x1899e4a65f58660dull }, { 0xb01ae745b101e9e4ull, 0x5ec05dcff72e7f90ull },
+  { 0xdc21a1171d42645dull, 0x76707543f4fa1f74ull }, { 0x899504ae72497ebaull, 0x6a06494a791c53a9ull },
+  { 0xabfa45da0edbde69ull, 0x0487db9d17636893ull }, { 0xd6f8d7509292d603ull, 0x45a9d2845d3c42b7ull },
+  { 0x865b86925b9bc5c2ull, 0x0b8a2392ba45a9b3ull }, { 0xa7f26836f282b732ull, 0x8e6cac7768d7141full },
+  { 0xd1ef0244af2364ffull, 0x3207d795430cd927ull }, { 0x8335616aed761f1full, 0x7f44e6bd49e807b9ull },
+  { 0xa402b9c5a8d3a6e7ull, 0x5f16206c9c6209a7ull }, { 0xcd036837130890a1ull, 0x36dba887c37a8c10ull },
+  { 0x802221226be55a64ull, 0xc2494954da2c978aull }, { 0xa02aa96b06deb0fdull, 0xf2db9baa10b7bd6dull },
+  { 0xc83553c5c8965d3dull, 0x6f92829494e5acc8ull }, { 0xfa42a8b73abbf48cull, 0xcb772339ba1f17faull },
+  { 0x9c69a97284b578d7ull, 0xff2a760414536efcull }, { 0xc38413cf25e2d70dull, 0xfef5138519684abbull },
+  { 0xf46518c2ef5b8cd1ull, 0x7eb258665fc25d6aull }, { 0x98bf2f79d5993802ull, 0xef2f773ffbd97a62ull },
+  { 0xbeeefb584aff8603ull, 0xaafb550ffacfd8fbull }, { 0xeeaaba2e5dbf6784ull, 0x95ba2a53f983cf39ull },
+  { 0x952ab45cfa97a0b2ull, 0xdd945a747bf26184ull }, { 0xba756174393d88dfull, 0x94f971119aeef9e5ull },
+  { 0xe912b9d1478ceb17ull, 0x7a37cd5601aab85eull }, { 0x91abb422ccb812eeull, 0xac62e055c10ab33bull },
+  { 0xb616a12b7fe617aaull, 0x577b986b314d600aull }, { 0xe39c49765fdf9d94ull, 0xed5a7e85fda0b80cull },
+  { 0x8e41ade9fbebc27dull, 0x14588f13be847308ull }, { 0xb1d219647ae6b31cull, 0x596eb2d8ae258fc9ull },
+  { 0xde469fbd99a05fe3ull, 0x6fca5f8ed9aef3bcull }, { 0x8aec23d680043beeull, 0x25de7bb9480d5855ull },
+  { 0xada72ccc20054ae9ull, 0xaf561aa79a10ae6bull }, { 0xd910f7ff28069da4ull, 0x1b2ba1518094da05ull },
+  { 0x87aa9aff79042286ull, 0x90fb44d2f05d0843ull }, { 0xa99541bf57452b28ull, 0x353a1607ac744a54ull },
+  { 0xd3fa922f2d1675f2ull, 0x42889b8997915ce9ull }, { 0x847c9b5d7c2e09b7ull, 0x69956135febada12ull },
+  { 0xa59bc234db398c25ull, 0x43fab9837e699096ull }, { 0xcf02b2c21207ef2eull, 0x94f967e45e03f4bcull },
+  { 0x8161afb94b44f57dull, 0x1d1be0eebac278f6ull }, { 0xa1ba1ba79e1632dcull, 0x6462d92a69731733ull },
+  { 0xca28a291859bbf93ull, 0x7d7b8f7503cfdcffull }, { 0xfcb2cb35e702af78ull, 0x5cda735244c3d43full },
+  { 0x9defbf01b061adabull, 0x3a0888136afa64a8ull }, { 0xc56baec21c7a1916ull, 0x088aaa1845b8fdd1ull },
+  { 0xf6c69a72a3989f5bull, 0x8aad549e57273d46ull }, { 0x9a3c2087a63f6399ull, 0x36ac54e2f678864cull },
+  { 0xc0cb28a98fcf3c7full, 0x84576a1bb416a7deull }, { 0xf0fdf2d3f3c30b9full, 0x656d44a2a11c51d6ull },
+  { 0x969eb7c47859e743ull, 0x9f644ae5a4b1b326ull }, { 0xbc4665b596706114ull, 0x873d5d9f0dde1fefull },
+  { 0xeb57ff22fc0c7959ull, 0xa90cb506d155a7ebull }, { 0x9316ff75dd87cbd8ull, 0x09a7f12442d588f3ull },
+  { 0xb7dcbf5354e9beceull, 0x0c11ed6d538aeb30ull }, { 0xe5d3ef282a242e81ull, 0x8f1668c8a86da5fbull },
+  { 0x8fa475791a569d10ull, 0xf96e017d694487bdull }, { 0xb38d92d760ec4455ull, 0x37c981dcc395a9adull },
+  { 0xe070f78d3927556aull, 0x85bbe253f47b1418ull }, { 0x8c469ab843b89562ull, 0x93956d7478ccec8full },
+  { 0xaf58416654a6babbull, 0x387ac8d1970027b3ull }, { 0xdb2e51bfe9d0696aull, 0x06997b05fcc0319full },
+  { 0x88fcf317f22241e2ull, 0x441fece3bdf81f04ull }, { 0xab3c2fddeeaad25aull, 0xd527e81cad7626c4ull },
+  { 0xd60b3bd56a5586f1ull, 0x8a71e223d8d3b075ull }, { 0x85c7056562757456ull, 0xf6872d5667844e4aull },
+  { 0xa738c6bebb12d16cull, 0xb428f8ac016561dcull }, { 0xd106f86e69d785c7ull, 0xe13336d701beba53ull },
+  { 0x82a45b450226b39cull, 0xecc0024661173474ull }, { 0xa34d721642b06084ull, 0x27f002d7f95d0191ull },
+  { 0xcc20ce9bd35c78a5ull, 0x31ec038df7b441f5ull }, { 0xff290242c83396ceull, 0x7e67047175a15272ull },
+  { 0x9f79a169bd203e41ull, 0x0f0062c6e984d387ull }, { 0xc75809c42c684dd1ull, 0x52c07b78a3e60869ull },
+  { 0xf92e0c3537826145ull, 0xa7709a56ccdf8a83ull }, { 0x9bbcc7a142b17ccbull, 0x88a66076400bb692ull },
+  { 0xc2abf989935ddbfeull, 0x6acff893d00ea436ull }, { 0xf356f7ebf83552feull, 0x0583f6b8c4124d44ull },
+  { 0x98165af37b2153deull, 0xc3727a337a8b704bull }, { 0xbe1bf1b059e9a8d6ull, 0x744f18c0592e4c5dull },
+  { 0xeda2ee1c7064130cull, 0x1162def06f79df74ull }, { 0x9485d4d1c63e8be7ull, 0x8addcb5645ac2ba9ull },
+  { 0xb9a74a0637ce2ee1ull, 0x6d953e2bd7173693ull }, { 0xe8111c87c5c1ba99ull, 0xc8fa8db6ccdd0438ull },
+  { 0x910ab1d4db9914a0ull, 0x1d9c9892400a22a3ull }, { 0xb54d5e4a127f59c8ull, 0x2503beb6d00cab4cull },
+  { 0xe2a0b5dc971f303aull, 0x2e44ae64840fd61eull }, { 0x8da471a9de737e24ull, 0x5ceaecfed289e5d3ull },
+  { 0xb10d8e1456105dadull, 0x7425a83e872c5f48ull }, { 0xdd50f1996b947518ull, 0xd12f124e28f7771aull },
+  { 0x8a5296ffe33cc92full, 0x82bd6b70d99aaa70ull }, { 0xace73cbfdc0bfb7bull, 0x636cc64d1001550cull },
+  { 0xd8210befd30efa5aull, 0x3c47f7e05401aa4full }, { 0x8714a775e3e95c78ull, 0x65acfaec34810a72ull },
+  { 0xa8d9d1535ce3b396ull, 0x7f1839a741a14d0eull }, { 0xd31045a8341ca07cull, 0x1ede48111209a051ull },
+  { 0x83ea2b892091e44dull, 0x934aed0aab460433ull }, { 0xa4e4b66b68b65d60ull, 0xf81da84d56178540ull },
+  { 0xce1de40642e3f4b9ull, 0x36251260ab9d668full }, { 0x80d2ae83e9ce78f3ull, 0xc1d72b7c6b42601aull },
+  { 0xa1075a24e4421730ull, 0xb24cf65b8612f820ull }, { 0xc94930ae1d529cfcull, 0xdee033f26797b628ull },
+  { 0xfb9b7cd9a4a7443cull, 0x169840ef017da3b2ull }, { 0x9d412e0806e88aa5ull, 0x8e1f289560ee864full },
+  { 0xc491798a08a2ad4eull, 0xf1a6f2bab92a27e3ull }, { 0xf5b5d7ec8acb58a2ull, 0xae10af696774b1dcull },
+  { 0x9991a6f3d6bf1765ull, 0xacca6da1e0a8ef2aull }, { 0xbff610b0cc6edd3full, 0x17fd090a58d32af4ull },
+  { 0xeff394dcff8a948eull, 0xddfc4b4cef07f5b1ull }, { 0x95f83d0a1fb69cd9ull, 0x4abdaf101564f98full },
+  { 0xbb764c4ca7a4440full, 0x9d6d1ad41abe37f2ull }, { 0xea53df5fd18d5513ull, 0x84c86189216dc5eeull },
+  { 0x92746b9be2f8552cull, 0x32fd3cf5b4e49bb5ull }, { 0xb7118682dbb66a77ull, 0x3fbc8c33221dc2a2ull },
+  { 0xe4d5e82392a40515ull, 0x0fabaf3feaa5334bull }, { 0x8f05b1163ba6832dull, 0x29cb4d87f2a7400full },
+  { 0xb2c71d5bca9023f8ull, 0x743e20e9ef511013ull }, { 0xdf78e4b2bd342cf6ull, 0x914da9246b255417ull },
+  { 0x8bab8eefb6409c1aull, 0x1ad089b6c2f7548full }, { 0xae9672aba3d0c320ull, 0xa184ac2473b529b2ull },
+  { 0xda3c0f568cc4f3e8ull, 0xc9e5d72d90a2741full }, { 0x8865899617fb1871ull, 0x7e2fa67c7a658893ull },
+  { 0xaa7eebfb9df9de8dull, 0xddbb901b98feeab8ull }, { 0xd51ea6fa85785631ull, 0x552a74227f3ea566ull },
+  { 0x8533285c936b35deull, 0xd53a88958f872760ull }, { 0xa67ff273b8460356ull, 0x8a892abaf368f138ull },
+  { 0xd01fef10a657842cull, 0x2d2b7569b0432d86ull }, { 0x8213f56a67f6b29bull, 0x9c3b29620e29fc74ull },
+  { 0xa298f2c501f45f42ull, 0x8349f3ba91b47b90ull }, { 0xcb3f2f7642717713ull, 0x241c70a936219a74ull },
+  { 0xfe0efb53d30dd4d7ull, 0xed238cd383aa0111ull }, { 0x9ec95d1463e8a506ull, 0xf4363804324a40abull },
+  { 0xc67bb4597ce2ce48ull, 0xb143c6053edcd0d6ull }, { 0xf81aa16fdc1b81daull, 0xdd94b7868e94050bull },
+  { 0x9b10a4e5e9913128ull, 0xca7cf2b4191c8327ull }, { 0xc1d4ce1f63f57d72ull, 0xfd1c2f611f63a3f1ull },
+  { 0xf24a01a73cf2dccfull, 0xbc633b39673c8cedull }, { 0x976e41088617ca01ull, 0xd5be0503e085d814ull },
+  { 0xbd49d14aa79dbc82ull, 0x4b2d8644d8a74e19ull }, { 0xec9c459d51852ba2ull, 0xddf8e7d60ed1219full },
+  { 0x93e1ab8252f33b45ull, 0xcabb90e5c942b504ull }, { 0xb8da1662e7b00a17ull, 0x3d6a751f3b936244ull },
+  { 0xe7109bfba19c0c9dull, 0x0cc512670a783ad5ull }, { 0x906a617d450187e2ull, 0x27fb2b80668b24c6ull },
+  { 0xb484f9dc9641e9daull, 0xb1f9f660802dedf7ull }, { 0xe1a63853bbd26451ull, 0x5e7873f8a0396974ull },
+  { 0x8d07e33455637eb2ull, 0xdb0b487b6423e1e9ull }, { 0xb049dc016abc5e5full, 0x91ce1a9a3d2cda63ull },
+  { 0xdc5c5301c56b75f7ull, 0x7641a140cc7810fcull }, { 0x89b9b3e11b6329baull, 0xa9e904c87fcb0a9eull },
+  { 0xac2820d9623bf429ull, 0x546345fa9fbdcd45ull }, { 0xd732290fbacaf133ull, 0xa97c177947ad4096ull },
+  { 0x867f59a9d4bed6c0ull, 0x49ed8eabcccc485eull }, { 0xa81f301449ee8c70ull, 0x5c68f256bfff5a75ull },
+  { 0xd226fc195c6a2f8cull, 0x73832eec6fff3112ull }, { 0x83585d8fd9c25db7ull, 0xc831fd53c5ff7eacull },
+  { 0xa42e74f3d032f525ull, 0xba3e7ca8b77f5e56ull }, { 0xcd3a1230c43fb26full, 0x28ce1bd2e55f35ecull },
+  { 0x80444b5e7aa7cf85ull, 0x7980d163cf5b81b4ull }, { 0xa0555e361951c366ull, 0xd7e105bcc3326220ull },
+  { 0xc86ab5c39fa63440ull, 0x8dd9472bf3fefaa8ull }, { 0xfa856334878fc150ull, 0xb14f98f6f0feb952ull },
+  { 0x9c935e00d4b9d8d2ull, 0x6ed1bf9a569f33d4ull }, { 0xc3b8358109e84f07ull, 0x0a862f80ec4700c9ull },
+  { 0xf4a642e14c6262c8ull, 0xcd27bb612758c0fbull }, { 0x98e7e9cccfbd7dbdull, 0x8038d51cb897789dull },
+  { 0xbf21e44003acdd2cull, 0xe0470a63e6bd56c4ull }, { 0xeeea5d5004981478ull, 0x1858ccfce06cac75ull },
+  { 0x95527a5202df0ccbull, 0x0f37801e0c43ebc9ull }, { 0xbaa718e68396cffdull, 0xd30560258f54e6bbull },
+  { 0xe950df20247c83fdull, 0x47c6b82ef32a206aull }, { 0x91d28b7416cdd27eull, 0x4cdc331d57fa5442ull },
+  { 0xb6472e511c81471dull, 0xe0133fe4adf8e953ull }, { 0xe3d8f9e563a198e5ull, 0x58180fddd97723a7ull },
+  { 0x8e679c2f5e44ff8full, 0x570f09eaa7ea7649ull }, { 0xb201833b35d63f73ull, 0x2cd2cc6551e513dbull },
+  { 0xde81e40a034bcf4full, 0xf8077f7ea65e58d2ull }, { 0x8b112e86420f6191ull, 0xfb04afaf27faf783ull },
+  { 0xadd57a27d29339f6ull, 0x79c5db9af1f9b564ull }, { 0xd94ad8b1c7380874ull, 0x18375281ae7822bdull },
+  { 0x87cec76f1c830548ull, 0x8f2293910d0b15b6ull }, { 0xa9c2794ae3a3c69aull, 0xb2eb3875504ddb23ull },
+  { 0xd433179d9c8cb841ull, 0x5fa60692a46151ecull }, { 0x849feec281d7f328ull, 0xdbc7c41ba6bcd334ull },
+  { 0xa5c7ea73224deff3ull, 0x12b9b522906c0801ull }, { 0xcf39e50feae16befull, 0xd768226b34870a01ull },
+  { 0x81842f29f2cce375ull, 0xe6a1158300d46641ull }, { 0xa1e53af46f801c53ull, 0x60495ae3c1097fd1ull },
+  { 0xca5e89b18b602368ull, 0x385bb19cb14bdfc5ull }, { 0xfcf62c1dee382c42ull, 0x46729e03dd9ed7b6ull },
+  { 0x9e19db92b4e31ba9ull, 0x6c07a2c26a8346d2ull }, { 0xc5a05277621be293ull, 0xc7098b7305241886ull },
+  { 0xf70867153aa2db38ull, 0xb8cbee4fc66d1ea8ull },
+};
+
+// multiplies two 64-bit values and returns the high half of the product.
+static inline uint64_t umul128(uint64_t a, uint64_t b, uint64_t *lo) {
+#if defined(__SIZEOF_INT128__)
+  uint128_t p = (uint128_t) a * b;
+  *lo = (uint64_t) p;
+  return (uint64_t) (p >> 64);
+#else
+  uint64_t ll = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF);
+  uint64_t lh = (a & 0xFFFFFFFF) * (b >> 32);
+  uint64_t hl = (a >> 32) * (b & 0xFFFFFFFF);
+  uint64_t hh = (a >> 32) * (b >> 32);
+  uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFF) + (hl & 0xFFFFFFFF);
+  *lo = (mid << 32) | (ll & 0xFFFFFFFF);
+  return hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
 }
 
-static size_t format_binary(fmt_buffer_t *buffer, const fmt_spec_t *spec) {
-  return format_integer(buffer, spec, false, &binary_format);
+// returns the upper 64 bits of the product of the power of ten and cp, rounded to odd.
+static inline uint64_t round_to_odd(const struct pow10_u128 *g, uint64_t cp) {
+  uint64_t x_lo;
+  uint64_t x_hi = umul128(g->lo, cp, &x_lo);
+  uint64_t y_lo;
+  uint64_t y_hi = umul128(g->hi, cp, &y_lo);
+
+  uint64_t y0 = y_lo + x_hi;
+  uint64_t y1 = y_hi + (y0 < y_lo);
+  return y1 | (y0 > 1);
 }
 
-static size_t format_octal(fmt_buffer_t *buffer, const fmt_spec_t *spec) {
-  return format_integer(buffer, spec, false, &octal_format);
+// picks the shortest digits inside the rounding interval from the scaled value vb and
+// bounds vbl and vbr, which are 4 times the value scaled by 10^-k.
+static inline uint64_t pick_shortest(uint64_t vbl, uint64_t vb, uint64_t vbr, bool is_even, int k, int *exp10) {
+  uint64_t lower = vbl + !is_even;
+  uint64_t upper = vbr - !is_even;
+
+  // one digit less is tried first
+  uint64_t s = vb / 4;
+  if (s >= 10) {
+    uint64_t sp = s / 10;
+    bool up_inside = lower <= 40 * sp;
+    bool wp_inside = 40 * sp + 40 <= upper;
+    if (up_inside != wp_inside) {
+      *exp10 = k + 1;
+      return sp + wp_inside;
+    }
+  }
+
+  bool u_inside = lower <= 4 * s;
+  bool w_inside = 4 * s + 4 <= upper;
+  if (u_inside != w_inside) {
+    *exp10 = k;
+    return s + w_inside;
+  }
+
+  // both candidates are inside, the closer one wins and the even one on a tie
+  uint64_t mid = 4 * s + 2;
+  bool round_up = vb > mid || (vb == mid && (s & 1) != 0);
+  *exp10 = k;
+  return s + round_up;
 }
 
-static size_t format_hex(fmt_buffer_t *buffer, const fmt_spec_t *spec) {
-  if (spec->flags & FMT_FLAG_UPPER) {
-    return format_integer(buffer, spec, false, &hex_upper_format);
+// returns the shortest decimal digits which read back as the double with the given
+// significand and biased exponent. exp10 is set to the exponent of the last digit.
+// the digits may have trailing zeros.
+static inline uint64_t double_to_shortest(uint64_t significand, int exponent, int *exp10) {
+  uint64_t c;
+  int q;
+  if (exponent != 0) {
+    c = significand | (1ull << 52);
+    q = exponent - 1075;
+    // integers below 2^53 are their own shortest representation
+    if (q <= 0 && q > -53 && (c & ((1ull << -q) - 1)) == 0) {
+      *exp10 = 0;
+      return c >> -q;
+    }
   } else {
-    return format_integer(buffer, spec, false, &hex_lower_format);
+    c = significand;
+    q = -1074;
   }
-}
 
-// Writes a floating point number to the buffer.
-// respects numeric flags. also supports the ALT flag for truncated
-// representations of whole numbers (e.g. 1.000000 -> 1).
-static inline size_t format_double(fmt_buffer_t *buffer, const fmt_spec_t *spec) {
-  union double_raw v = { .value = spec->value.double_value };
-  size_t width = (size_t) min(max(spec->width, 0), FMTLIB_MAX_WIDTH);
-  size_t prec = (size_t) min((spec->precision > 0 ? spec->precision : PRECISION_DEFAULT), PRECISION_MAX);
-  size_t n = 0;
+  // the value and the bounds of its rounding interval times 4. the lower bound is
+  // closer if the value is a power of two.
+  bool is_even = (c & 1) == 0;
+  bool lower_is_closer = significand == 0 && exponent > 1;
+  uint64_t cbl = 4 * c - 2 + lower_is_closer;
+  uint64_t cb = 4 * c;
+  uint64_t cbr = 4 * c + 2;
 
-  // write sign or space to buffer
-  if (v.sign) {
-    n += fmtlib_buffer_write_char(buffer, '-');
-  } if (spec->flags & FMT_FLAG_SIGN) {
-    n += fmtlib_buffer_write_char(buffer, '+');
-  } else if (spec->flags & FMT_FLAG_SPACE) {
-    n += fmtlib_buffer_write_char(buffer, ' ');
-  }
+  // k is floor(log10(2^q)), or floor(log10(3/4 * 2^q)) if the lower bound is closer,
+  // and h is the shift which lines up the binary exponents of 2^q and 10^-k.
+  int k = (q * 1262611 - (lower_is_closer ? 524031 : 0)) >> 22;
+  int h = q + ((-k * 1741647) >> 19) + 1;
+  const struct pow10_u128 *g = &pow10_u128[-k - POW10_MIN_EXP];
+  uint64_t vbl = round_to_odd(g, cbl << h);
+  uint64_t vb = round_to_odd(g, cb << h);
+  uint64_t vbr = round_to_odd(g, cbr << h);
+  return pick_shortest(vbl, vb, vbr, is_even, k, exp10);
+}
 
-  // handle special encodings
-  if (v.exp == 0x7FF && v.frac == 0) {
-    // infinity
-    const char *inf = spec->flags & FMT_FLAG_UPPER ? "INF" : "inf";
-    n += fmtlib_buffer_write(buffer, inf, 3);
-    return n;
-  } else if (v.exp == 0x7FF && v.frac != 0) {
-    // NaN
-    const char *nan = spec->flags & FMT_FLAG_UPPER ? "NAN" : "nan";
-    n += fmtlib_buffer_write(buffer, nan, 3);
-    return n;
-  } else if (v.exp == 0 && v.frac == 0) {
-    // zero
-    n += fmtlib_buffer_write_char(buffer, '0');
-    if (!(spec->flags & FMT_FLAG_ALT)) {
-      n += fmtlib_buffer_write_char(buffer, '.');
-      for (size_t i = 0; i < prec; i++) {
-        n += fmtlib_buffer_write_char(buffer, '0');
-      }
+// returns the upper 64 bits of the product of the power of ten rounded up to 64 bits
+// and cp, shifted down by 31 and rounded to odd. this is precise enough for floats.
+static inline uint64_t round_to_odd_float(uint64_t g, uint64_t cp) {
+  uint64_t lo;
+  uint64_t x = umul128(g, cp, &lo);
+  return (x >> 31) | ((x & 0x7FFFFFFF) != 0);
+}
+
+// returns the shortest decimal digits which read back as the float with the given
+// significand and biased exponent, like double_to_shortest. only the upper half of
+// the powers of ten is used, so the scaling is a single 64-bit multiply.
+static inline uint64_t float_to_shortest(uint32_t significand, int exponent, int *exp10) {
+  uint32_t c;
+  int q;
+  if (exponent != 0) {
+    c = significand | (1u << 23);
+    q = exponent - 150;
+    // integers below 2^24 are their own shortest representation
+    if (q <= 0 && q > -24 && (c & ((1u << -q) - 1)) == 0) {
+      *exp10 = 0;
+      return c >> -q;
     }
-    return n;
+  } else {
+    c = significand;
+    q = -149;
   }
 
-  if (v.value < 0) {
-    v.value = -v.value;
-  }
+  bool is_even = (c & 1) == 0;
+  bool lower_is_closer = significand == 0 && exponent > 1;
+  uint64_t cbl = 4 * (uint64_t) c - 2 + lower_is_closer;
+  uint64_t cb = 4 * (uint64_t) c;
+  uint64_t cbr = 4 * (uint64_t) c + 2;
+
+  // the shift leaves 31 extra bits in the product which are folded into the odd bit
+  int k = (q * 1262611 - (lower_is_closer ? 524031 : 0)) >> 22;
+  int h = q + ((-k * 1741647) >> 19) + 32;
+  uint64_t g = pow10_u128[-k - POW10_MIN_EXP].hi + 1;
+  uint64_t vbl = round_to_odd_float(g, cbl << h);
+  uint64_t vb = round_to_odd_float(g, cb << h);
+  uint64_t vbr = round_to_odd_float(g, cbr << h);
+  return pick_shortest(vbl, vb, vbr, is_even, k, exp10);
+}
 
-  // now to convert floating point numbers to strings we need to extract the whole
-  // and fractional parts as integers. from there we simply convert each to a string
-  // then write them to the buffer.
-  uint64_t whole = (uint64_t) v.value;
-  uint64_t frac;
+// Writes the sign and the digits of d * 10^exp10 in the notation of format_shortest.
+static size_t write_shortest(fmt_buffer_t *buffer, const fmt_spec_t *spec, bool is_negative, uint64_t d, int exp10) {
+  bool upper = spec->flags & FMT_FLAG_UPPER;
+  bool alt = spec->flags & FMT_FLAG_ALT;
 
-  // shift the decimal point to the right by the specified precision
-  double tmp = (v.value - (double)whole) * pow10[prec];
-  frac = (uint64_t) tmp;
+  // the sign and zero padding are written by write_integer, without a minimum
+  // number of digits or prefix
+  fmt_spec_t num_spec = *spec;
+  num_spec.precision = 0;
+  num_spec.flags &= ~FMT_FLAG_ALT;
 
-  // round the remaining fractional part
-  double delta = tmp - (double)frac;
-  if (delta > 0.5) {
-    frac++;
-    // handle rollover, e.g. case 0.99 with prec 1 is 1.0
-    if (frac >= (uint64_t)pow10[prec]) {
-      frac = 0;
-      whole++;
+  char digits[20];
+  int len = 1;
+  if (d == 0) {
+    digits[0] = '0';
+    exp10 = 0;
+  } else {
+    while (d % 10 == 0) {
+      d /= 10;
+      exp10++;
     }
-  } else if (delta < 0.5) {
-    // do nothing
-  } else if ((frac == 0) || (frac & 1)) {
-    // if halfway, round up if odd or last digit is 0
-    frac++;
+    len = (int) u64_to_dec(d, digits);
   }
 
-  // the only time we _dont_ want to write the decimal point and fraction is
-  // when the fraction is zero while the ALT flag is set.
-  bool write_decimal = !(frac == 0 && (spec->flags & FMT_FLAG_ALT));
+  // the decimal point goes after the first point digits
+  char temp[32];
+  char *ptr = temp;
+  int point = exp10 + len;
+  if (point - 1 < -4 || point - 1 >= 16) {
+    *ptr++ = digits[0];
+    if (len > 1 || alt) {
+      *ptr++ = '.';
+      memcpy(ptr, digits + 1, len - 1);
+      ptr += len - 1;
+    }
+    if (len == 1 && alt) {
+      *ptr++ = '0';
+    }
 
-  // write the whole part to the intermediate buffer
-  char temp[TEMP_BUFFER_SIZE];
-  size_t len = u64_to_str(whole, temp, &decimal_format);
-  size_t frac_len = 0;
-  if (write_decimal) {
-    temp[len++] = '.';
-    // write the fractional part to the intermediate buffer
-    frac_len = u64_to_str(frac, temp + len, &decimal_format);
-    len += frac_len;
+    ptr += exponent_to_str(point - 1, upper, ptr);
+  } else if (point <= 0) {
+    *ptr++ = '0';
+    *ptr++ = '.';
+    memset(ptr, '0', -point);
+    ptr += -point;
+    memcpy(ptr, digits, len);
+    ptr += len;
+  } else if (point < len) {
+    memcpy(ptr, digits, point);
+    ptr += point;
+    *ptr++ = '.';
+    memcpy(ptr, digits + point, len - point);
+    ptr += len - point;
+  } else {
+    memcpy(ptr, digits, len);
+    ptr += len;
+    memset(ptr, '0', point - len);
+    ptr += point - len;
+    if (alt) {
+      *ptr++ = '.';
+      *ptr++ = '0';
+    }
   }
+  return write_integer(buffer, &num_spec, is_negative, &decimal_format, temp, ptr - temp);
+}
 
-  // left-pad number with zeros to reach specified width
-  if (spec->flags & FMT_FLAG_ZERO && width > len + n) {
-    if (width > len + n) {
-      size_t padding = width - len - n;
-      for (size_t i = 0; i < padding; i++) {
-        n += fmtlib_buffer_write_char(buffer, '0');
-      }
-    }
+// Writes a double with the fewest digits that read back as the same value. like the
+// repr of Python, values from 1e-4 up to 1e16 are written in fixed notation and all
+// others in scientific notation, e.g. 0.1, 123.456 or 1e+100. the alternate form
+// always includes a decimal point. with a precision it is written like printf %g.
+static size_t format_shortest(fmt_buffer_t *buffer, const fmt_spec_t *spec) {
+  if (spec->precision > 0) {
+    return format_general(buffer, spec);
   }
 
-  // now write the number to the buffer
-  n += fmtlib_buffer_write(buffer, temp, len);
+  union double_raw v = { .value = spec->value.double_value };
+  if (v.exp == 0x7FF) {
+    return format_special(buffer, spec, v);
+  }
 
-  // finally write the trailing zeros to the buffer
-  if (write_decimal && prec > frac_len) {
-    size_t padding = prec - frac_len;
-    for (size_t i = 0; i < padding; i++) {
-      n += fmtlib_buffer_write_char(buffer, '0');
-    }
+  uint64_t d = 0;
+  int exp10 = 0;
+  if (v.exp != 0 || v.frac != 0) {
+    d = double_to_shortest(v.frac, v.exp, &exp10);
   }
-  return n;
+  return write_shortest(buffer, spec, v.sign, d, exp10);
+}
+
+// Writes a float with the fewest digits that read back as the same float, e.g. 0.1f
+// is written as 0.1 and not as the digits of the double it converts to. floats are
+// passed as doubles so the value is converted back first. with a precision it is
+// written like printf %g, which is the same for both.
+static size_t format_shortest_float(fmt_buffer_t *buffer, const fmt_spec_t *spec) {
+  if (spec->precision > 0) {
+    return format_general(buffer, spec);
+  }
+
+  union double_raw v = { .value = spec->value.double_value };
+  if (v.exp == 0x7FF) {
+    return format_special(buffer, spec, v);
+  }
+
+  union float_raw f = { .value = (float) spec->value.double_value };
+  uint64_t d = 0;
+  int exp10 = 0;
+  if (f.exp != 0 || f.frac != 0) {
+    d = float_to_shortest(f.frac, f.exp, &exp10);
+  }
+  return write_shortest(buffer, spec, f.sign, d, exp10);
 }
 
 static size_t format_string(fmt_buffer_t *buffer, const fmt_spec_t *spec) {
   const char *str = spec->value.voidptr_value;
-  size_t len = spec->precision;
+  size_t len = 0;
   if (str == NULL) {
     str = "(null)";
     len = 6;
-  } else if (len == 0) {
+  } else if (spec->precision == 0) {
     len = strlen(str);
+  } else {
+    // the precision is the maximum length, the string is not read past it
+    while (len < spec->precision && str[len] != 0) {
+      len++;
+    }
   }
 
   return fmtlib_buffer_write(buffer, str, len);
@@ -304,24 +2151,16 @@ static inline size_t apply_alignment(fmt_buffer_t *buffer, const fmt_spec_t *spe
   switch (spec->align) {
     case FMT_ALIGN_LEFT:
       n += fmtlib_buffer_write(buffer, str, len);
-      for (size_t i = 0; i < padding; i++) {
-        n += fmtlib_buffer_write_char(buffer, pad_char);
-      }
+      n += fmtlib_buffer_fill(buffer, pad_char, padding);
       break;
     case FMT_ALIGN_RIGHT:
-      for (size_t i = 0; i < padding; i++) {
-        n += fmtlib_buffer_write_char(buffer, pad_char);
-      }
+      n += fmtlib_buffer_fill(buffer, pad_char, padding);
       n += fmtlib_buffer_write(buffer, str, len);
       break;
     case FMT_ALIGN_CENTER:
-      for (size_t i = 0; i < padding / 2; i++) {
-        n += fmtlib_buffer_write_char(buffer, pad_char);
-      }
+      n += fmtlib_buffer_fill(buffer, pad_char, padding / 2);
       n += fmtlib_buffer_write(buffer, str, len);
-      for (size_t i = 0; i < padding - padding / 2; i++) {
-        n += fmtlib_buffer_write_char(buffer, pad_char);
-      }
+      n += fmtlib_buffer_fill(buffer, pad_char, padding - padding / 2);
       break;
   }
   return n;
@@ -340,6 +2179,25 @@ static inline size_t resolve_integral_type(fmt_spec_t *spec) {
   } else if (ptr[n] == 'z') {
     argtype = FMT_ARGTYPE_SIZE;
     n += 1;
+#if defined(__SIZEOF_INT128__)
+  } else if (ptr[n] == 'w' && ptr[n+1] == '1' && ptr[n+2] == '2' && ptr[n+3] == '8') {
+    // 128-bit values are passed by pointer
+    switch (ptr[n+4]) {
+      case 'd': formatter = format_signed128; break;
+      case 'u': formatter = format_unsigned128; break;
+      case 'b': formatter = format_binary128; break;
+      case 'o': formatter = format_octal128; break;
+      case 'X': flags |= FMT_FLAG_UPPER; // fallthrough
+      case 'x': formatter = format_hex128; break;
+      default:
+        return 0; // unknown type
+    }
+
+    spec->flags = flags;
+    spec->argtype = FMT_ARGTYPE_VOIDPTR;
+    spec->formatter = formatter;
+    return 1;
+#endif
   } else {
     argtype = FMT_ARGTYPE_INT32;
   }
@@ -351,6 +2209,46 @@ static inline size_t resolve_integral_type(fmt_spec_t *spec) {
     case 'o': formatter = format_octal; break;
     case 'X': flags |= FMT_FLAG_UPPER; // fallthrough
     case 'x': formatter = format_hex; break;
+    case 'R': flags |= FMT_FLAG_UPPER; // fallthrough
+    case 'r':
+      spec->base = parse_radix(&ptr[n+1]);
+      if (spec->base == 0)
+        return 0; // unsupported base
+      formatter = format_radix;
+      break;
+    case 'k': formatter = format_fixed; break;
+    default:
+      return 0; // unknown type
+  }
+
+  spec->flags = flags;
+  spec->argtype = argtype;
+  spec->formatter = formatter;
+  return 1;
+}
+
+// Resolves a floating point type. the 'h' modifier selects a float argument, which
+// is only formatted differently by the shortest formatter.
+static inline size_t resolve_float_type(fmt_spec_t *spec) {
+  fmt_argtype_t argtype = FMT_ARGTYPE_DOUBLE;
+  fmt_formatter_t formatter;
+  int flags = spec->flags;
+  const char *ptr = spec->type;
+
+  if (*ptr == 'h') {
+    argtype = FMT_ARGTYPE_FLOAT;
+    ptr++;
+  }
+
+  switch (*ptr) {
+    case 'F': flags |= FMT_FLAG_UPPER; // fallthrough
+    case 'f': formatter = format_double; break;
+    case 'E': flags |= FMT_FLAG_UPPER; // fallthrough
+    case 'e': formatter = format_exp; break;
+    case 'G': flags |= FMT_FLAG_UPPER; // fallthrough
+    case 'g': formatter = argtype == FMT_ARGTYPE_FLOAT ? format_shortest_float : format_shortest; break;
+    case 'A': flags |= FMT_FLAG_UPPER; // fallthrough
+    case 'a': formatter = format_hexfloat; break;
     default:
       return 0; // unknown type
   }
@@ -374,13 +2272,18 @@ int fmtlib_resolve_type(fmt_spec_t *spec) {
     return 1;
   }
 
+  if (resolve_float_type(spec)) {
+    return 1;
+  }
+
   switch (spec->type[0]) {
-    case 'F': spec->flags |= FMT_FLAG_UPPER; // fallthrough
-    case 'f': spec->argtype = FMT_ARGTYPE_DOUBLE; spec->formatter = format_double; return 1;
     case 's': spec->argtype = FMT_ARGTYPE_VOIDPTR; spec->formatter = format_string; return 1;
     case 'c': spec->argtype = FMT_ARGTYPE_INT32; spec->formatter = format_char; return 1;
     case 'p': spec->flags |= FMT_FLAG_ALT;
               spec->argtype = FMT_ARGTYPE_VOIDPTR; spec->formatter = format_hex; return 1;
+#if defined(__SIZEOF_INT128__)
+    case 'N': spec->argtype = FMT_ARGTYPE_VOIDPTR; spec->formatter = format_bigint; return 1;
+#endif
   }
 
   // type not found
@@ -389,6 +2292,28 @@ int fmtlib_resolve_type(fmt_spec_t *spec) {
   return 0;
 }
 
+int fmtlib_resolve_default(fmt_spec_t *spec, fmt_argclass_t argclass) {
+  const char *type;
+  uint8_t type_len = 1;
+  switch (argclass) {
+    case FMT_ARGCLASS_SIGNED: type = "d"; spec->formatter = format_signed; break;
+    case FMT_ARGCLASS_UNSIGNED: type = "u"; spec->formatter = format_unsigned; break;
+    case FMT_ARGCLASS_DOUBLE: type = "g"; spec->formatter = format_shortest; break;
+    case FMT_ARGCLASS_FLOAT: type = "hg"; type_len = 2;
+                             spec->formatter = format_shortest_float; break;
+    case FMT_ARGCLASS_STRING: type = "s"; spec->formatter = format_string; break;
+    case FMT_ARGCLASS_CHAR: type = "c"; spec->formatter = format_char; break;
+    case FMT_ARGCLASS_POINTER: type = "p"; spec->flags |= FMT_FLAG_ALT;
+                               spec->formatter = format_hex; break;
+    default:
+      return 0;
+  }
+
+  spec->type = type;
+  spec->type_len = type_len;
+  return 1;
+}
+
 size_t fmtlib_parse_printf_type(const char *format, const char **end) {
   // %[flags][width][.precision]type
   //    `                       ^ format
@@ -401,32 +2326,60 @@ size_t fmtlib_parse_printf_type(const char *format, const char **end) {
   switch (*ptr) {
     case 'd': case 'u': case 'b':
     case 'o': case 'x': case 'X':
-    case 'f': case 'F': case 's':
-    case 'c': case 'p':
+    case 'k': case 'f': case 'F':
+    case 'e': case 'E': case 'g': case 'G':
+    case 'a': case 'A':
+    case 's': case 'c': case 'p':
       *end = ptr + 1;
       return 1;
     case 'l':
       if (ptr[1] == 'l') {
         if (ptr[2] == 'd' || ptr[2] == 'u' || ptr[2] == 'b' ||
-            ptr[2] == 'o' || ptr[2] == 'x' || ptr[2] == 'X') {
+            ptr[2] == 'o' || ptr[2] == 'x' || ptr[2] == 'X' || ptr[2] == 'k') {
           *end = ptr + 3;
           return 3;
         }
       }
       break;
+    case 'h':
+      if (ptr[1] == 'f' || ptr[1] == 'F' || ptr[1] == 'e' ||
+          ptr[1] == 'E' || ptr[1] == 'g' || ptr[1] == 'G' ||
+          ptr[1] == 'a' || ptr[1] == 'A') {
+        *end = ptr + 2;
+        return 2;
+      }
+      break;
     case 'z':
       if (ptr[1] == 'd' || ptr[1] == 'u' || ptr[1] == 'b' ||
-          ptr[1] == 'o' || ptr[1] == 'x' || ptr[1] == 'X') {
+          ptr[1] == 'o' || ptr[1] == 'x' || ptr[1] == 'X' || ptr[1] == 'k') {
         *end = ptr + 2;
         return 2;
       }
       break;
+    case 'w':
+      if (ptr[1] == '1' && ptr[2] == '2' && ptr[3] == '8') {
+        if (ptr[4] == 'd' || ptr[4] == 'u' || ptr[4] == 'b' ||
+            ptr[4] == 'o' || ptr[4] == 'x' || ptr[4] == 'X') {
+          *end = ptr + 5;
+          return 5;
+        }
+      }
+      break;
   }
 
   *end = format;
   return 0;
 }
 
+// returns the length of the formatted value by formatting it into a buffer which
+// only counts the writes.
+__attribute__((noinline))
+static size_t measure_value(const fmt_spec_t *spec) {
+  fmt_buffer_t counter = { .data = NULL, .size = 0 };
+  spec->formatter(&counter, spec);
+  return counter.written;
+}
+
 size_t fmtlib_format_spec(fmt_buffer_t *buffer, fmt_spec_t *spec) {
   if (spec->type_len == 0) {
     // no type specified, just apply alignment/padding
@@ -435,16 +2388,230 @@ size_t fmtlib_format_spec(fmt_buffer_t *buffer, fmt_spec_t *spec) {
     return 0;
   }
 
-  // if width is specified, we need to format the value into a temporary buffer
-  // and then apply alignment/padding. otherwise we can just format directly
-  // into the output buffer. this means that format strings specifying a width
-  // are limited to FMTLIB_MAX_WIDTH characters.
-  if (spec->width > 0) {
-    char value_data[TEMP_BUFFER_SIZE];
-    fmt_buffer_t value = fmtlib_buffer(value_data, TEMP_BUFFER_SIZE);
+  size_t width = spec->width;
+  if (width == 0) {
+    return spec->formatter(buffer, spec);
+  }
+
+  // left aligned values are padded after they have been written
+  if (spec->align == FMT_ALIGN_LEFT) {
+    size_t n = spec->formatter(buffer, spec);
+    if (n < width) {
+      n += fmtlib_buffer_fill(buffer, spec->fill_char, width - n);
+    }
+    return n;
+  }
+
+  // right and center aligned values are written where the field starts and then
+  // moved behind the padding.
+  char *start = buffer->data;
+  size_t size = buffer->size;
+  size_t n = spec->formatter(buffer, spec);
+  size_t len = n;
+  if (n == size && n < width) {
+    // the value filled the buffer so its length is not known. it only matters for
+    // the part of the padding that still fits.
+    len = measure_value(spec);
+  }
+  if (len >= width) {
+    return n;
+  }
+
+  size_t padding = width - len;
+  size_t before = spec->align == FMT_ALIGN_RIGHT ? padding : padding / 2;
+  size_t keep = before < size ? min(n, size - before) : 0;
+  if (keep > 0) {
+    memmove(start + before, start, keep);
+  }
+
+  // rewind and write the field again around the value which is already in place
+  buffer->data = start;
+  buffer->size = size;
+  buffer->written -= n;
+
+  n = fmtlib_buffer_fill(buffer, spec->fill_char, before);
+  buffer->data += keep;
+  buffer->size -= keep;
+  buffer->written += keep;
+  n += keep;
+  n += fmtlib_buffer_fill(buffer, spec->fill_char, padding - before);
+  return n;
+}
+
+size_t fmtlib_spec_max_len(const fmt_spec_t *spec) {
+  fmt_formatter_t formatter = spec->formatter;
+  size_t precision = spec->precision;
+  size_t len;
+  if (spec->type_len == 0 || formatter == NULL) {
+    len = 0;
+  } else if (formatter == format_signed || formatter == format_unsigned) {
+    len = 1 + max(precision, 20);
+  } else if (formatter == format_binary || formatter == format_radix) {
+    len = 1 + 2 + max(precision, 64);
+  } else if (formatter == format_octal) {
+    len = 1 + 2 + max(precision, 22);
+  } else if (formatter == format_hex) {
+    len = 1 + 2 + max(precision, 16);
+  } else if (formatter == format_fixed) {
+    len = 1 + 22 + precision;
+  } else if (formatter == format_double) {
+    // the sign, the integer part of the largest double and the fraction
+    len = 1 + FIXED_INT_DIGITS + 1 + (precision > 0 ? precision : PRECISION_DEFAULT);
+  } else if (formatter == format_exp) {
+    // the sign, a digit and the point, the fraction and an exponent of up to e+308
+    len = 1 + 2 + (precision > 0 ? precision : PRECISION_DEFAULT) + 5;
+  } else if (formatter == format_shortest || formatter == format_shortest_float) {
+    // the sign and the digits with either "0.0000" or the point and exponent
+    len = 1 + max(precision, 17) + 6;
+  } else if (formatter == format_hexfloat) {
+    // the sign, the prefix, a digit and the point, the fraction and an exponent of up to p-1022
+    len = 1 + 2 + 2 + max(precision, 13) + 6;
+  } else if (formatter == format_char) {
+    len = 2;
+  } else if (formatter == format_string && precision > 0) {
+    len = max(precision, 6);
+#if defined(__SIZEOF_INT128__)
+  } else if (formatter == format_signed128 || formatter == format_unsigned128 || formatter == format_binary128 ||
+             formatter == format_octal128 || formatter == format_hex128) {
+    len = 1 + 2 + max(precision, 128);
+#endif
+  } else {
+    // strings without a precision, big integers and custom formatters
+    return SIZE_MAX;
+  }
+  return max(len, (size_t) spec->width);
+}
+
+size_t fmtlib_format_spec_unchecked(fmt_buffer_t *buffer, fmt_spec_t *spec) {
+  fmt_formatter_t formatter = spec->formatter;
+  if (spec->type_len == 0) {
+    return fmtlib_format_spec(buffer, spec);
+  } else if (formatter == format_signed || formatter == format_unsigned) {
+    return put_integer(buffer, spec, formatter == format_signed, &decimal_format);
+  } else if (formatter == format_hex) {
+    return put_integer(buffer, spec, false, spec->flags & FMT_FLAG_UPPER ? &hex_upper_format : &hex_lower_format);
+  } else if (formatter == format_binary) {
+    return put_integer(buffer, spec, false, &binary_format);
+  } else if (formatter == format_octal) {
+    return put_integer(buffer, spec, false, &octal_format);
+  }
+  // the other formatters cannot run out of room either, they just keep their checks
+  return fmtlib_format_spec(buffer, spec);
+}
+
+// reads an element of an integer array the same way an argument of the type is read.
+static inline uint64_t load_integer(const void *values, size_t i, fmt_argtype_t argtype) {
+  switch (argtype) {
+    case FMT_ARGTYPE_INT32: return (uint64_t) ((const int32_t *) values)[i];
+    case FMT_ARGTYPE_SIZE: return (uint64_t) ((const size_t *) values)[i];
+    default: return (uint64_t) ((const int64_t *) values)[i];
+  }
+}
+
+int fmtlib_format_array(fmt_buffer_t *buffer, const fmt_spec_t *spec, const void *values, size_t count,
+                        const char *separator, size_t separator_len, size_t *written) {
+  bool is_signed = spec->formatter == format_signed;
+  if (!is_signed && spec->formatter != format_unsigned) {
+    return 0;
+  } else if (spec->width != 0 || spec->precision != 0 || (spec->flags & (FMT_FLAG_SIGN | FMT_FLAG_SPACE | FMT_FLAG_ZERO))) {
+    return 0;
+  }
+
+  fmt_argtype_t argtype = spec->argtype;
+  if (argtype != FMT_ARGTYPE_INT32 && argtype != FMT_ARGTYPE_INT64 && argtype != FMT_ARGTYPE_SIZE) {
+    return 0;
+  }
+
+  size_t n = 0;
+  size_t i = 0;
+#if defined(__SSE2__)
+  // groups of four elements are written straight to the buffer while it has room
+  // for the longest possible group. values below 10^16 are converted as two halves
+  // of 8 digits by the vector kernel and those below 10^8 only need the lower half.
+  // the separator and the digits are copied in fixed-size chunks which may run past
+  // their length, so the next element simply overwrites the excess.
+  if (separator_len <= 8) {
+    char sep[8] = { 0 };
+    memcpy(sep, separator, separator_len);
+
+    char *ptr = buffer->data;
+    char *end = buffer->data + buffer->size;
+    while (count - i >= 4 && end - ptr >= 4 * 40) {
+      uint64_t v[4];
+      bool is_negative[4];
+      uint64_t largest = 0;
+      for (int k = 0; k < 4; k++) {
+        v[k] = load_integer(values, i + k, argtype);
+        is_negative[k] = is_signed && (int64_t) v[k] < 0;
+        v[k] = is_negative[k] ? -v[k] : v[k];
+        largest |= v[k];
+      }
+
+      // the upper halves are only needed if any value has more than 8 digits
+      char lo_digits[40];
+      char hi_digits[40];
+      bool has_hi = largest >= 100000000;
+      bool is_long = largest >= 10000000000000000ull;
+      if (has_hi && !is_long) {
+        uint32_t hi[4];
+        for (int k = 0; k < 4; k++) {
+          hi[k] = (uint32_t) (v[k] / 100000000);
+          v[k] -= (uint64_t) hi[k] * 100000000;
+        }
+        u32x4_to_dec_sse2(_mm_setr_epi32((int) hi[0], (int) hi[1], (int) hi[2], (int) hi[3]), hi_digits);
+        u32x4_to_dec_sse2(_mm_setr_epi32((int) v[0], (int) v[1], (int) v[2], (int) v[3]), lo_digits);
+        for (int k = 0; k < 4; k++) {
+          v[k] += (uint64_t) hi[k] * 100000000;
+        }
+      } else if (!is_long) {
+        u32x4_to_dec_sse2(_mm_setr_epi32((int) v[0], (int) v[1], (int) v[2], (int) v[3]), lo_digits);
+      }
+
+      for (int k = 0; k < 4; k++, i++) {
+        if (i > 0) {
+          copy8_sse2(ptr, sep);
+          ptr += separator_len;
+        }
+        *ptr = '-';
+        ptr += is_negative[k];
+        if (is_long) {
+          ptr += u64_to_dec(v[k], ptr);
+          continue;
+        }
+
+        size_t len = v[k] == 0 ? 1 : (size_t) count_digits(v[k]);
+        if (len > 8) {
+          copy8_sse2(ptr, hi_digits + k * 8 + 16 - len);
+          ptr += len - 8;
+          len = 8;
+        }
+        copy8_sse2(ptr, lo_digits + k * 8 + 8 - len);
+        ptr += len;
+      }
+    }
+
+    size_t m = ptr - buffer->data;
+    buffer->data = ptr;
+    buffer->size -= m;
+    buffer->written += m;
+    n = m;
+  }
+#endif
+
+  for (; i < count && !fmtlib_buffer_full(buffer); i++) {
+    if (i > 0) {
+      n += fmtlib_buffer_write(buffer, separator, separator_len);
+    }
 
-    size_t n = spec->formatter(&value, spec);
-    return apply_alignment(buffer, spec, value_data, n);
+    uint64_t v = load_integer(values, i, argtype);
+    bool is_negative = is_signed && (int64_t) v < 0;
+    char temp[24];
+    temp[0] = '-';
+    size_t len = is_negative;
+    len += u64_to_dec(is_negative ? -v : v, temp + len);
+    n += fmtlib_buffer_write(buffer, temp, len);
   }
-  return spec->formatter(buffer, spec);
+
+  *written = n;
+  return 1;
 }
@@ -12,12 +12,28 @@
 #include <stdarg.h>
 #include <string.h>
 
-// determines the maximum width that can be specified
-#define FMTLIB_MAX_WIDTH 256
-
 // determines the maximum allowed length of a specifier type name.
 #define FMTLIB_MAX_TYPE_LEN 16
 
+// determines the size of the lookup table used to convert integers to decimal.
+// 2 uses a 200 byte table of digit pairs, 4 uses a 40000 byte table of groups
+// of four digits and 0 converts one digit at a time without a table.
+#ifndef FMTLIB_DIGIT_TABLE
+#define FMTLIB_DIGIT_TABLE 2
+#endif
+
+// determines the largest big integer in 64-bit limbs which is converted on the stack.
+// the conversion uses about 100 bytes of stack per limb. larger values are converted
+// in the scratch limbs of the fmt_bigint_t.
+#ifndef FMTLIB_BIGINT_MAX_LIMBS
+#define FMTLIB_BIGINT_MAX_LIMBS 32
+#endif
+
+// the number of scratch limbs needed to format a big integer of count limbs which is
+// larger than FMTLIB_BIGINT_MAX_LIMBS. this holds the powers of ten, quotients and
+// remainders of the conversion (6 limbs per limb plus 80) and 20 digits per limb.
+#define FMTLIB_BIGINT_SCRATCH_LIMBS(count) (6 * (count) + 80 + (5 * (count) + 1) / 2)
+
 // -----------------------------------------------------------------------------
 
 #define FMT_FLAG_ALT    0x01 // alternate form
@@ -39,8 +55,22 @@ typedef enum fmt_argtype {
   FMT_ARGTYPE_DOUBLE,
   FMT_ARGTYPE_SIZE,
   FMT_ARGTYPE_VOIDPTR,
+  FMT_ARGTYPE_FLOAT, // passed and stored as a double
 } fmt_argtype_t;
 
+/// The kind of value an argument holds. This is used to pick a default
+/// formatter for typed arguments whose specifier has no type.
+typedef enum fmt_argclass {
+  FMT_ARGCLASS_NONE,
+  FMT_ARGCLASS_SIGNED,
+  FMT_ARGCLASS_UNSIGNED,
+  FMT_ARGCLASS_DOUBLE,
+  FMT_ARGCLASS_FLOAT,
+  FMT_ARGCLASS_STRING,
+  FMT_ARGCLASS_CHAR,
+  FMT_ARGCLASS_POINTER,
+} fmt_argclass_t;
+
 typedef union fmt_raw_value {
   uint64_t uint64_value;
   double double_value;
@@ -50,31 +80,56 @@ typedef union fmt_raw_value {
 #define fmt_rawvalue_double(v) ((union fmt_raw_value) { .double_value = (v) })
 #define fmt_rawvalue_voidptr(v) ((union fmt_raw_value) { .voidptr_value = (v) })
 
+/// An arbitrary-precision integer for the 'N' type. The magnitude is stored in 64-bit
+/// limbs with the least significant limb first. Values of more than FMTLIB_BIGINT_MAX_LIMBS
+/// limbs are only formatted if scratch has room for FMTLIB_BIGINT_SCRATCH_LIMBS(count) limbs,
+/// up to 2^24 limbs.
+typedef struct fmt_bigint {
+  const uint64_t *limbs;
+  size_t count;
+  bool negative;
+  uint64_t *scratch;    // work space for large values or NULL
+  size_t scratch_count; // number of scratch limbs
+} fmt_bigint_t;
+
 typedef struct fmt_spec fmt_spec_t;
 typedef struct fmt_buffer fmt_buffer_t;
 
 /// A function which writes a string to the buffer formatted according to the given specifier.
+/// It returns the number of characters written, the padding for the spec width is applied
+/// around them afterwards.
 typedef size_t (*fmt_formatter_t)(fmt_buffer_t *buffer, const fmt_spec_t *spec);
 
-/// Represents a fully-formed format specifier.
+/// Represents a fully-formed format specifier. Specs are copied for every value
+/// that is formatted so they are kept small. The type name is not copied, it
+/// points into the format string and is not null-terminated.
 typedef struct fmt_spec {
-  char type[FMTLIB_MAX_TYPE_LEN + 1];
-  size_t type_len;
-  int flags;
-  int width;
-  int precision;
-  fmt_align_t align;
-  char fill_char;
-  const char *end;
-  //
-  fmt_raw_value_t value;
-  fmt_argtype_t argtype;
+  const char *type;
   fmt_formatter_t formatter;
+  fmt_raw_value_t value;
+  uint16_t width;
+  uint16_t precision;
+  uint8_t flags;
+  uint8_t type_len;
+  char fill_char;
+  unsigned align : 4;   // fmt_align_t
+  unsigned argtype : 4; // fmt_argtype_t
+  uint8_t base;         // base of the 'r' type, resolved with the formatter
 } fmt_spec_t;
 
+/// Converts a width or precision value to the range that fits in a spec.
+/// Negative values are treated as unset.
+static inline uint16_t fmtlib_spec_int(int64_t value) {
+  if (value < 0)
+    return 0;
+  return value > UINT16_MAX ? UINT16_MAX : (uint16_t) value;
+}
+
 // MARK: fmt_buffer_t API
 // ======================
 // This simple struct is used to safely bounds-check all writes to the buffer.
+// A buffer with no data and a size of 0 discards all writes and only counts
+// them in written.
 
 typedef struct fmt_buffer {
   char *data;
@@ -95,8 +150,11 @@ static inline bool fmtlib_buffer_full(fmt_buffer_t *b) {
 }
 
 static inline size_t fmtlib_buffer_write(fmt_buffer_t *b, const char *data, size_t size) {
-  if (b->size == 0)
+  if (b->size == 0) {
+    if (b->data == NULL)
+      b->written += size;
     return 0;
+  }
   size_t n = size < b->size ? size : b->size;
   memcpy(b->data, data, n);
   b->data += n;
@@ -105,9 +163,26 @@ static inline size_t fmtlib_buffer_write(fmt_buffer_t *b, const char *data, size
   return n;
 }
 
+static inline size_t fmtlib_buffer_fill(fmt_buffer_t *b, char c, size_t count) {
+  size_t n = count < b->size ? count : b->size;
+  if (n == 0) {
+    if (b->data == NULL)
+      b->written += count;
+    return 0;
+  }
+  memset(b->data, c, n);
+  b->data += n;
+  b->size -= n;
+  b->written += n;
+  return n;
+}
+
 static inline size_t fmtlib_buffer_write_char(fmt_buffer_t *b, char c) {
-  if (b->size == 0)
+  if (b->size == 0) {
+    if (b->data == NULL)
+      b->written++;
     return 0;
+  }
   *b->data = c;
   b->data++;
   b->size--;
@@ -128,6 +203,17 @@ static inline size_t fmtlib_buffer_write_char(fmt_buffer_t *b, char c) {
  */
 int fmtlib_resolve_type(fmt_spec_t *spec);
 
+/**
+ * Resolves the default formatter for a value of the given class. This is used
+ * in place of fmtlib_resolve_type for specifiers without a type when the type
+ * of the argument is known. The spec type is set to the name of the default type.
+ *
+ * @param spec The format specifier
+ * @param argclass The class of the argument
+ * @return 1 on success, 0 if the class has no default formatter
+ */
+int fmtlib_resolve_default(fmt_spec_t *spec, fmt_argclass_t argclass);
+
 /**
  * Parses a type within a printf-style specifier.
  *
@@ -149,4 +235,41 @@ size_t fmtlib_parse_printf_type(const char *format, const char **end);
  */
 size_t fmtlib_format_spec(fmt_buffer_t *buffer, fmt_spec_t *spec);
 
+/**
+ * Returns an upper bound of the number of bytes written when any value is formatted
+ * according to the given specifier.
+ *
+ * @param spec the specifier
+ * @return the upper bound or SIZE_MAX if the output length is not bounded
+ */
+size_t fmtlib_spec_max_len(const fmt_spec_t *spec);
+
+/**
+ * Formats a value according to the given specifier like fmtlib_format_spec, but
+ * integers are written without any bounds checks. The buffer must have room for
+ * at least fmtlib_spec_max_len(spec) bytes.
+ *
+ * @param buffer the buffer to write the formatted value to
+ * @param spec the specifier
+ * @return the number of bytes written
+ */
+size_t fmtlib_format_spec_unchecked(fmt_buffer_t *buffer, fmt_spec_t *spec);
+
+/**
+ * Formats an array of integers in decimal with the separator between the elements.
+ * This is the batch path for specifiers which only select a decimal integer type,
+ * for any other specifier nothing is written and 0 is returned.
+ *
+ * @param buffer the buffer to write the formatted values to
+ * @param spec the specifier
+ * @param values the elements, of the size given by the spec argtype
+ * @param count the number of elements
+ * @param separator the separator
+ * @param separator_len the length of the separator
+ * @param [out] written the number of bytes written
+ * @return 1 if the array was formatted, 0 if the specifier is not supported
+ */
+int fmtlib_format_array(fmt_buffer_t *buffer, const fmt_spec_t *spec, const void *values, size_t count,
+                        const char *separator, size_t separator_len, size_t *written);
+
 #endif
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <mach/mach_time.h>
 
@@ -52,12 +53,661 @@ static void fmt_test_case(const char *expected, const char *format, ...) __attri
   printf(GREEN"[PASS]"RESET" \"%s\" in %llu ns\n", expected, ns_avg);
 }
 
+static void fmt_check(const char *name, const char *expected, const char *actual) {
+  if (strcmp(actual, expected) != 0) {
+    printf(RED"[FAIL]"RESET" %s\n", name);
+    printf("  expected: \"%s\"\n", expected);
+    printf("  actual:   \"%s\"\n", actual);
+    return;
+  }
+  printf(GREEN"[PASS]"RESET" \"%s\" (%s)\n", actual, name);
+}
+
+static void fmt_scratch_test_case(const char *expected, const char *format, ...) {
+  char buffer[4096];
+  fmt_arg_t scratch[16];
+
+  va_list args;
+  va_start(args, format);
+  fmt_format_scratch(format, buffer, sizeof(buffer), scratch, 16, args);
+  va_end(args);
+  fmt_check("scratch", expected, buffer);
+}
+
+static void fmt_args_test_case(const char *expected, const char *format, const fmt_arg_t *args, int num_args) __attribute__((optnone)) {
+  const size_t size = 4096;
+  char buffer[size];
+
+  uint64_t start = get_time_ns();
+  fmt_format_args(format, buffer, size, args, num_args);
+  uint64_t end = get_time_ns();
+  uint64_t ns = end - start;
+
+  if (strcmp(buffer, expected) != 0) {
+    printf(RED"[FAIL]"RESET" \"%s\" (args) in %llu ns\n", format, ns);
+    printf("  expected: \"%s\"\n", expected);
+    printf("  actual:   \"%s\"\n", buffer);
+    return;
+  }
+
+  for (int i = 0; i < BENCH_ITERATIONS; i++) {
+    start = get_time_ns();
+    fmt_format_args(format, buffer, size, args, num_args);
+    end = get_time_ns();
+    ns += end - start;
+  }
+
+  printf(GREEN"[PASS]"RESET" \"%s\" in %llu ns (args)\n", expected, ns / BENCH_ITERATIONS);
+}
+
+static bool test_provider(void *ctx, int index, fmt_argtype_t argtype, fmt_raw_value_t *value) {
+  if (index >= *(int *)ctx)
+    return false;
+  *value = fmt_rawvalue_uint64(index * 10);
+  return true;
+}
+
+// compiles the format and benchmarks it against fmt_format
+static void fmt_compiled_test_case(const char *expected, const char *format, ...) __attribute__((optnone)) {
+  const size_t size = 4096;
+  char buffer[size];
+  fmt_op_t ops[16];
+  fmt_compiled_t compiled;
+
+  if (fmt_compile(format, &compiled, ops, 16) < 0) {
+    printf(RED"[FAIL]"RESET" \"%s\" failed to compile\n", format);
+    return;
+  }
+
+  va_list args;
+  va_start(args, format);
+  fmt_format_compiled(&compiled, buffer, size, args);
+  va_end(args);
+
+  if (strcmp(buffer, expected) != 0) {
+    printf(RED"[FAIL]"RESET" \"%s\" (compiled)\n", format);
+    printf("  expected: \"%s\"\n", expected);
+    printf("  actual:   \"%s\"\n", buffer);
+    return;
+  }
+
+  // the output must be within the bound of the format. a buffer which only just fits
+  // the output is usually below the bound, so this goes through the checked writers.
+  char exact[size];
+  va_start(args, format);
+  fmt_format_compiled(&compiled, exact, strlen(expected) + 1, args);
+  va_end(args);
+  if (strlen(expected) > compiled.max_len || strcmp(exact, expected) != 0) {
+    printf(RED"[FAIL]"RESET" \"%s\" (compiled, checked)\n", format);
+    printf("  expected: \"%s\" (bound %zu)\n", expected, compiled.max_len);
+    printf("  actual:   \"%s\"\n", exact);
+    return;
+  }
+
+  uint64_t start, end;
+  uint64_t ns = 0;
+  uint64_t ns_interp = 0;
+  for (int i = 0; i < BENCH_ITERATIONS; i++) {
+    va_start(args, format);
+    start = get_time_ns();
+    fmt_format_compiled(&compiled, buffer, size, args);
+    end = get_time_ns();
+    va_end(args);
+    ns += end - start;
+
+    va_start(args, format);
+    start = get_time_ns();
+    fmt_format(format, buffer, size, FMT_MAX_ARGS, args);
+    end = get_time_ns();
+    va_end(args);
+    ns_interp += end - start;
+  }
+
+  printf(GREEN"[PASS]"RESET" \"%s\" in %llu ns (compiled, %llu ns interpreted)\n",
+         expected, ns / BENCH_ITERATIONS, ns_interp / BENCH_ITERATIONS);
+}
+
+// benchmarks fmt_write_static against fmt_write for the same format
+static void fmt_static_test_case(void) __attribute__((optnone)) {
+  const char *expected = "42, hi";
+  const size_t size = 4096;
+  char data[size];
+
+  uint64_t start, end;
+  uint64_t ns = 0;
+  uint64_t ns_write = 0;
+  for (int i = 0; i <= BENCH_ITERATIONS; i++) {
+    fmt_buffer_t buffer = { .data = data, .size = size };
+    start = get_time_ns();
+    fmt_write_static(&buffer, "{:d}, {:s}", 42, "hi");
+    end = get_time_ns();
+    ns += end - start;
+
+    if (strcmp(data, expected) != 0) {
+      printf(RED"[FAIL]"RESET" \"{:d}, {:s}\" (static)\n");
+      printf("  expected: \"%s\"\n", expected);
+      printf("  actual:   \"%s\"\n", data);
+      return;
+    }
+
+    buffer = (fmt_buffer_t) { .data = data, .size = size };
+    start = get_time_ns();
+    fmt_write(&buffer, "{:d}, {:s}", 42, "hi");
+    end = get_time_ns();
+    ns_write += end - start;
+  }
+
+  printf(GREEN"[PASS]"RESET" \"%s\" in %llu ns (static, %llu ns fmt_write)\n",
+         expected, ns / BENCH_ITERATIONS, ns_write / BENCH_ITERATIONS);
+}
+
+// benchmarks appending many small writes to one large buffer
+static void fmt_append_test_case(void) __attribute__((optnone)) {
+  const char *expected = "0 1 2 3 4 5 6 7 8 9 ";
+  static char data[65536];
+  memset(data, 'x', sizeof(data));
+
+  fmt_buffer_t buffer = { .data = data, .size = sizeof(data) };
+  uint64_t start = get_time_ns();
+  for (int i = 0; i < 1000; i++) {
+    fmt_write(&buffer, "{:d} ", i % 10);
+  }
+  uint64_t end = get_time_ns();
+
+  data[strlen(expected)] = 0;
+  if (strcmp(data, expected) != 0 || buffer.written != 2000 || *buffer.data != 0) {
+    printf(RED"[FAIL]"RESET" \"{:d} \" (append)\n");
+    printf("  expected: \"%s\"\n", expected);
+    printf("  actual:   \"%s\"\n", data);
+    return;
+  }
+  printf(GREEN"[PASS]"RESET" \"%s\" in %llu ns per write (append)\n", expected, (end - start) / 1000);
+}
+
+// benchmarks formatting an array at once against writing each element and separator
+static void fmt_array_bench(void) __attribute__((optnone)) {
+  static char buffer[16384];
+  static char split[16384];
+  int32_t values[1000];
+  uint32_t x = 2463534242u;
+  for (int i = 0; i < 1000; i++) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    values[i] = (int32_t) x >> (x % 32);
+  }
+
+  uint64_t start = get_time_ns();
+  for (int i = 0; i < BENCH_ITERATIONS / 10; i++) {
+    fmt_buffer_t out = { .data = buffer, .size = sizeof(buffer) };
+    fmt_write_array(&out, "{:d}", values, 1000, ",");
+  }
+  uint64_t end = get_time_ns();
+
+  uint64_t ns_split = get_time_ns();
+  for (int i = 0; i < BENCH_ITERATIONS / 10; i++) {
+    fmt_buffer_t out = { .data = split, .size = sizeof(split) };
+    fmt_write(&out, "{:d}", values[0]);
+    for (int j = 1; j < 1000; j++) {
+      fmt_write(&out, ",{:d}", values[j]);
+    }
+  }
+  ns_split = get_time_ns() - ns_split;
+
+  if (strcmp(buffer, split) != 0) {
+    printf(RED"[FAIL]"RESET" \"{:d}\" (array)\n");
+    printf("  expected: \"%.64s...\"\n", split);
+    printf("  actual:   \"%.64s...\"\n", buffer);
+    return;
+  }
+  printf(GREEN"[PASS]"RESET" \"{:d}\" with 1000 elements in %llu ns per element (array, %llu ns fmt_write)\n",
+         (end - start) / (BENCH_ITERATIONS / 10 * 1000), ns_split / (BENCH_ITERATIONS / 10 * 1000));
+}
+
+// checks that floats formatted with {:hg} and doubles formatted with {:g} read back as
+// the same value. every float32 is tried in exhaustive mode and every 4099th one
+// otherwise, followed by random float64 bit patterns.
+static void fmt_shortest_round_trip_test(bool exhaustive) {
+  char buffer[64];
+  uint64_t count = 0;
+  uint64_t step = exhaustive ? 1 : 4099;
+  for (uint64_t i = 0; i < (1ull << 32); i += step) {
+    uint32_t bits = (uint32_t) i;
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    if (f != f || f - f != 0) {
+      continue; // nan or inf
+    }
+
+    fmt_format_args("{:hg}", buffer, sizeof(buffer), &fmt_arg_float(f), 1);
+    if (strtof(buffer, NULL) != f) {
+      printf(RED"[FAIL]"RESET" \"{:hg}\" (float32 round trip)\n");
+      printf("  expected: %.9g\n", f);
+      printf("  actual:   \"%s\"\n", buffer);
+      return;
+    }
+    count++;
+  }
+
+  uint64_t x = 88172645463325252ull;
+  for (int i = 0; i < 1000000; i++) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    double d;
+    memcpy(&d, &x, sizeof(d));
+    if (d != d || d - d != 0) {
+      continue;
+    }
+
+    fmt_format_args("{:g}", buffer, sizeof(buffer), &fmt_arg_double(d), 1);
+    if (strtod(buffer, NULL) != d) {
+      printf(RED"[FAIL]"RESET" \"{:g}\" (float64 round trip)\n");
+      printf("  expected: %.17g\n", d);
+      printf("  actual:   \"%s\"\n", buffer);
+      return;
+    }
+    count++;
+  }
+  printf(GREEN"[PASS]"RESET" \"{:hg}\" \"{:g}\" round trip %llu values (shortest)\n", count);
+}
+
+// checks the fixed, scientific, general and hexadecimal doubles against printf for random values
+// and precisions
+static void fmt_printf_double_test(void) {
+  const char *types = "feEgGaA";
+  char buffer[1200];
+  char expected[1200];
+  char format[32];
+  uint64_t x = 2463534242ull;
+  for (int i = 0; i < 100000; i++) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    double d;
+    memcpy(&d, &x, sizeof(d));
+    if (d != d || d - d != 0) {
+      continue;
+    }
+
+    int precision = i % 16 == 0 ? 1074 : 1 + i % 40;
+    char type = types[i % 7];
+    snprintf(format, sizeof(format), "{:.%d%c}", precision, type);
+    snprintf(expected, sizeof(expected), (char[]) { '%', '.', '*', type, 0 }, precision, d);
+    fmt_format_args(format, buffer, sizeof(buffer), &fmt_arg_double(d), 1);
+    if (strcmp(buffer, expected) != 0) {
+      printf(RED"[FAIL]"RESET" \"%s\" (printf doubles)\n", format);
+      printf("  expected: \"%s\"\n", expected);
+      printf("  actual:   \"%s\"\n", buffer);
+      return;
+    }
+  }
+  printf(GREEN"[PASS]"RESET" \"{:.*f}\" \"{:.*e}\" \"{:.*g}\" \"{:.*a}\" match printf (printf doubles)\n");
+}
+
+// benchmarks the shortest floats against promoting them to doubles
+static void fmt_float_bench(void) __attribute__((optnone)) {
+  const float values[] = { 0.1f, 3.14159f, 2.0f / 3.0f, 123456.789f, 1e-7f, 6.02214076e23f, 1.5f, 299792458.0f };
+  const int count = sizeof(values) / sizeof(values[0]);
+  char buffer[64];
+  char promoted[64];
+
+  uint64_t start = get_time_ns();
+  for (int i = 0; i < BENCH_ITERATIONS; i++) {
+    for (int j = 0; j < count; j++) {
+      fmt_format_args("{:hg}", buffer, sizeof(buffer), &fmt_arg_float(values[j]), 1);
+    }
+  }
+  uint64_t end = get_time_ns();
+
+  uint64_t ns_double = get_time_ns();
+  for (int i = 0; i < BENCH_ITERATIONS; i++) {
+    for (int j = 0; j < count; j++) {
+      fmt_format_args("{:g}", promoted, sizeof(promoted), &fmt_arg_double(values[j]), 1);
+    }
+  }
+  ns_double = get_time_ns() - ns_double;
+
+  if (strcmp(buffer, "299792450") != 0) {
+    printf(RED"[FAIL]"RESET" \"{:hg}\" (floats)\n");
+    printf("  expected: \"299792450\"\n");
+    printf("  actual:   \"%s\"\n", buffer);
+    return;
+  }
+  printf(GREEN"[PASS]"RESET" \"{:hg}\" in %llu ns per float (floats, %llu ns promoted {:g})\n",
+         (end - start) / (BENCH_ITERATIONS * count), ns_double / (BENCH_ITERATIONS * count));
+}
+
+// benchmarks the shortest doubles against the fixed and scientific notation and printf
+static void fmt_double_bench(void) __attribute__((optnone)) {
+  const double values[] = { 0.1, 3.14159, 2.0 / 3.0, 123456.789, 1e-7, 6.02214076e23, 1.5, 299792458.0 };
+  const int count = sizeof(values) / sizeof(values[0]);
+  char buffer[64];
+  char fixed[64];
+  char expected[64];
+
+  uint64_t start = get_time_ns();
+  for (int i = 0; i < BENCH_ITERATIONS; i++) {
+    for (int j = 0; j < count; j++) {
+      fmt_format_args("{:g}", buffer, sizeof(buffer), &fmt_arg_double(values[j]), 1);
+    }
+  }
+  uint64_t end = get_time_ns();
+
+  uint64_t ns_fixed = get_time_ns();
+  for (int i = 0; i < BENCH_ITERATIONS; i++) {
+    for (int j = 0; j < count; j++) {
+      fmt_format_args("{:f}", fixed, sizeof(fixed), &fmt_arg_double(values[j]), 1);
+    }
+  }
+  ns_fixed = get_time_ns() - ns_fixed;
+
+  uint64_t ns_exp = get_time_ns();
+  for (int i = 0; i < BENCH_ITERATIONS; i++) {
+    for (int j = 0; j < count; j++) {
+      fmt_format_args("{:e}", fixed, sizeof(fixed), &fmt_arg_double(values[j]), 1);
+    }
+  }
+  ns_exp = get_time_ns() - ns_exp;
+
+  uint64_t ns_printf = get_time_ns();
+  for (int i = 0; i < BENCH_ITERATIONS; i++) {
+    for (int j = 0; j < count; j++) {
+      snprintf(expected, sizeof(expected), "%.17g", values[j]);
+    }
+  }
+  ns_printf = get_time_ns() - ns_printf;
+
+  if (strcmp(buffer, "299792458") != 0) {
+    printf(RED"[FAIL]"RESET" \"{:g}\" (doubles)\n");
+    printf("  expected: \"299792458\"\n");
+    printf("  actual:   \"%s\"\n", buffer);
+    return;
+  }
+  printf(GREEN"[PASS]"RESET" \"{:g}\" in %llu ns per double (doubles, %llu ns {:f}, %llu ns {:e}, %llu ns %%.17g)\n",
+         (end - start) / (BENCH_ITERATIONS * count), ns_fixed / (BENCH_ITERATIONS * count),
+         ns_exp / (BENCH_ITERATIONS * count), ns_printf / (BENCH_ITERATIONS * count));
+}
+
+// benchmarks the specifier parser on its own by compiling a corpus of specifiers
+static void fmt_parse_bench(void) __attribute__((optnone)) {
+  static const char *corpus[] = {
+    "{}", "{:d}", "{0:s}", "{1:.2f}", "{:#x}", "{:08X}", "{:$.>*b}", "{:^20s}",
+    "{2:+d}", "{:-10d}", "{:*.*f}", "{:#!llx}", "{:zu}", "{:$*<12p}", "{3:c}",
+    "%d", "%s", "%5d", "%-8s", "%08x", "%.3f", "%llu", "%zx", "%#o", "%+d",
+  };
+  const int count = sizeof(corpus) / sizeof(corpus[0]);
+
+  fmt_op_t ops[4];
+  fmt_compiled_t compiled;
+  uint64_t start = get_time_ns();
+  for (int i = 0; i < BENCH_ITERATIONS; i++) {
+    for (int j = 0; j < count; j++) {
+      if (fmt_compile(corpus[j], &compiled, ops, 4) != 1) {
+        printf(RED"[FAIL]"RESET" \"%s\" (parse)\n", corpus[j]);
+        return;
+      }
+    }
+  }
+  uint64_t end = get_time_ns();
+  printf(GREEN"[PASS]"RESET" %d specifiers in %llu ns per specifier (parse)\n",
+         count, (end - start) / ((uint64_t) BENCH_ITERATIONS * count));
+}
+
+// benchmarks integer conversion across all decimal lengths. expected is the
+// output for the last and largest value.
+static void fmt_integer_bench(const char *format, const char *expected) __attribute__((optnone)) {
+  char buffer[128];
+  uint64_t values[20];
+  uint64_t value = 1;
+  for (int i = 0; i < 20; i++) {
+    values[i] = value;
+    value = value * 10 + 3;
+  }
+
+  uint64_t start = get_time_ns();
+  for (int i = 0; i < BENCH_ITERATIONS; i++) {
+    for (int j = 0; j < 20; j++) {
+      fmt_arg_t arg = fmt_arg_uint64(values[j]);
+      fmt_format_args(format, buffer, sizeof(buffer), &arg, 1);
+    }
+  }
+  uint64_t end = get_time_ns();
+
+  if (strcmp(buffer, expected) != 0) {
+    printf(RED"[FAIL]"RESET" \"%s\" (integers)\n", format);
+    printf("  expected: \"%s\"\n", expected);
+    printf("  actual:   \"%s\"\n", buffer);
+    return;
+  }
+  printf(GREEN"[PASS]"RESET" \"%s\" in %llu ns per integer (integers)\n",
+         format, (end - start) / (BENCH_ITERATIONS * 20));
+}
+
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 test_uint128_t;
+
+// benchmarks 128-bit decimal conversion against splitting the value at 10^19 by hand
+// and formatting both halves
+static void fmt_int128_bench(void) __attribute__((optnone)) {
+  const uint64_t chunk = 10000000000000000000ull;
+  const char *expected = "8888888888888888888888888888888888888";
+  char buffer[128];
+  char split[128];
+  test_uint128_t values[18];
+  test_uint128_t value = 8;
+  for (int i = 0; i < 18; i++) {
+    value = value * 100 + 88;
+    values[i] = value;
+  }
+
+  uint64_t start = get_time_ns();
+  for (int i = 0; i < BENCH_ITERATIONS; i++) {
+    for (int j = 0; j < 18; j++) {
+      fmt_arg_t arg = fmt_arg_voidptr(&values[j]);
+      fmt_format_args("{:w128u}", buffer, sizeof(buffer), &arg, 1);
+    }
+  }
+  uint64_t end = get_time_ns();
+  uint64_t ns_split = get_time_ns();
+  for (int i = 0; i < BENCH_ITERATIONS; i++) {
+    for (int j = 0; j < 18; j++) {
+      fmt_arg_t args[] = { fmt_arg_uint64(values[j] / chunk), fmt_arg_uint64(values[j] % chunk) };
+      fmt_format_args("{:llu}{:019llu}", split, sizeof(split), args, 2);
+    }
+  }
+  ns_split = get_time_ns() - ns_split;
+
+  if (strcmp(buffer, expected) != 0 || strcmp(split, expected) != 0) {
+    printf(RED"[FAIL]"RESET" \"{:w128u}\" (int128)\n");
+    printf("  expected: \"%s\"\n", expected);
+    printf("  actual:   \"%s\"\n", buffer);
+    return;
+  }
+  printf(GREEN"[PASS]"RESET" \"{:w128u}\" in %llu ns per integer (int128, %llu ns split)\n",
+         (end - start) / (BENCH_ITERATIONS * 18), ns_split / (BENCH_ITERATIONS * 18));
+}
+
+// benchmarks big integer conversion against dividing the value by 10^19 by hand and
+// formatting each chunk
+static void fmt_bigint_bench(void) __attribute__((optnone)) {
+  const uint64_t chunk = 10000000000000000000ull;
+  static char buffer[1024];
+  static char split[1024];
+  uint64_t limbs[32];
+  uint64_t x = 88172645463325252ull;
+  for (int i = 0; i < 32; i++) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    limbs[i] = x;
+  }
+
+  fmt_bigint_t value = { .limbs = limbs, .count = 32 };
+  uint64_t start = get_time_ns();
+  for (int i = 0; i < BENCH_ITERATIONS; i++) {
+    fmt_arg_t arg = fmt_arg_voidptr(&value);
+    fmt_format_args("{:N}", buffer, sizeof(buffer), &arg, 1);
+  }
+  uint64_t end = get_time_ns();
+
+  uint64_t ns_split = get_time_ns();
+  for (int i = 0; i < BENCH_ITERATIONS; i++) {
+    uint64_t temp[32];
+    uint64_t chunks[40];
+    int count = 0;
+    int n = 32;
+    memcpy(temp, limbs, sizeof(temp));
+    while (n > 0) {
+      test_uint128_t rem = 0;
+      for (int j = n - 1; j >= 0; j--) {
+        test_uint128_t cur = (rem << 64) | temp[j];
+        temp[j] = (uint64_t) (cur / chunk);
+        rem = cur % chunk;
+      }
+      chunks[count++] = (uint64_t) rem;
+      while (n > 0 && temp[n-1] == 0)
+        n--;
+    }
+
+    fmt_buffer_t out = fmtlib_buffer(split, sizeof(split));
+    fmt_write(&out, "{:llu}", chunks[--count]);
+    while (count > 0) {
+      fmt_write(&out, "{:019llu}", chunks[--count]);
+    }
+  }
+  ns_split = get_time_ns() - ns_split;
+
+  if (strcmp(buffer, split) != 0) {
+    printf(RED"[FAIL]"RESET" \"{:N}\" (bigint)\n");
+    printf("  expected: \"%s\"\n", split);
+    printf("  actual:   \"%s\"\n", buffer);
+    return;
+  }
+  printf(GREEN"[PASS]"RESET" \"{:N}\" with 32 limbs in %llu ns (bigint, %llu ns split)\n",
+         (end - start) / BENCH_ITERATIONS, ns_split / BENCH_ITERATIONS);
+}
+
+// checks a 4096-bit value, which is above FMTLIB_BIGINT_MAX_LIMBS and is converted in
+// the scratch limbs, against dividing it by 10^19 by hand
+static void fmt_bigint_large_test(void) {
+  const uint64_t chunk = 10000000000000000000ull;
+  static char buffer[2048];
+  static char expected[2048];
+  uint64_t limbs[64];
+  uint64_t scratch[FMTLIB_BIGINT_SCRATCH_LIMBS(64)];
+  uint64_t x = 2463534242ull;
+  for (int i = 0; i < 64; i++) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    limbs[i] = x;
+  }
+
+  uint64_t temp[64];
+  uint64_t chunks[80];
+  int count = 0;
+  int n = 64;
+  memcpy(temp, limbs, sizeof(temp));
+  while (n > 0) {
+    test_uint128_t rem = 0;
+    for (int j = n - 1; j >= 0; j--) {
+      test_uint128_t cur = (rem << 64) | temp[j];
+      temp[j] = (uint64_t) (cur / chunk);
+      rem = cur % chunk;
+    }
+    chunks[count++] = (uint64_t) rem;
+    while (n > 0 && temp[n-1] == 0)
+      n--;
+  }
+
+  // the sign and the zeros of the precision go in front of the digits
+  count--;
+  int len = snprintf(expected, sizeof(expected), "-%0*llu", 1300 - 19 * count, chunks[count]);
+  while (count > 0) {
+    len += snprintf(expected + len, sizeof(expected) - len, "%019llu", chunks[--count]);
+  }
+
+  fmt_bigint_t value = { .limbs = limbs, .count = 64, .negative = true };
+  fmt_format_args("{:.1300N}", buffer, sizeof(buffer), &fmt_arg_voidptr(&value), 1);
+  if (strcmp(buffer, "{bigint too large}") != 0) {
+    printf(RED"[FAIL]"RESET" \"{:N}\" (bigint without scratch)\n");
+    printf("  actual:   \"%s\"\n", buffer);
+    return;
+  }
+
+  value.scratch = scratch;
+  value.scratch_count = FMTLIB_BIGINT_SCRATCH_LIMBS(64);
+  fmt_format_args("{:.1300N}", buffer, sizeof(buffer), &fmt_arg_voidptr(&value), 1);
+  if (strcmp(buffer, expected) != 0) {
+    printf(RED"[FAIL]"RESET" \"{:.1300N}\" (bigint with scratch)\n");
+    printf("  expected: \"%s\"\n", expected);
+    printf("  actual:   \"%s\"\n", buffer);
+    return;
+  }
+  printf(GREEN"[PASS]"RESET" \"{:.1300N}\" with 64 limbs (bigint with scratch)\n");
+}
+#endif
+
+// checks that specs whose output is padded by the precision stay within the bound of the
+// compiled format. the destination only just fits the bound so the integer after the
+// padded spec is written without bounds checks and would run past the end otherwise.
+// unbounded formats only just fit the output instead.
+static void fmt_compiled_bound_test(void) {
+#if defined(__SIZEOF_INT128__)
+  static uint64_t limbs[] = { 42 };
+  static fmt_bigint_t big = { .limbs = limbs, .count = 1 };
+  static test_uint128_t u128 = 42;
+#endif
+  struct { const char *format; fmt_arg_t arg; } cases[] = {
+    { "{:.670d}{:lld}", fmt_arg_int32(42) },
+    { "{:#.670x}{:lld}", fmt_arg_int32(42) },
+    { "{:.670r36}{:lld}", fmt_arg_int32(42) },
+    { "{:.670k}{:lld}", fmt_arg_int32(-42) },
+    { "{:.670f}{:lld}", fmt_arg_double(-1.7976931348623157e308) },
+    { "{:.670e}{:lld}", fmt_arg_double(-1e-300) },
+    { "{:.670g}{:lld}", fmt_arg_double(-1e-300) },
+    { "{:.670a}{:lld}", fmt_arg_double(-1e-300) },
+    { "{:.670s}{:lld}", fmt_arg_string("hi") },
+    { "{:.670f}{:lld}", fmt_arg_string("hi") },
+#if defined(__SIZEOF_INT128__)
+    { "{:.670w128u}{:lld}", fmt_arg_voidptr(&u128) },
+    { "{:.670N}{:lld}", fmt_arg_voidptr(&big) },
+#endif
+  };
+
+  char expected[2048];
+  char buffer[2048];
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    fmt_op_t ops[4];
+    fmt_compiled_t compiled;
+    fmt_arg_t args[] = { cases[i].arg, fmt_arg_int64(INT64_MIN) };
+    fmt_compile(cases[i].format, &compiled, ops, 4);
+    fmt_format_args(cases[i].format, expected, sizeof(expected), args, 2);
+
+    memset(buffer, '#', sizeof(buffer));
+    size_t size = compiled.max_len == SIZE_MAX ? strlen(expected) + 1 : compiled.max_len + 1;
+    if (size < sizeof(buffer)) {
+      fmt_format_compiled_args(&compiled, buffer, size, args, 2);
+    }
+    if (size >= sizeof(buffer) || strlen(expected) > compiled.max_len || strcmp(buffer, expected) != 0 ||
+        buffer[size] != '#') {
+      printf(RED"[FAIL]"RESET" \"%s\" (compiled bound)\n", cases[i].format);
+      printf("  expected: \"%s\" (bound %zu)\n", expected, compiled.max_len);
+      printf("  actual:   \"%.*s\"\n", (int) sizeof(buffer) - 1, buffer);
+      return;
+    }
+  }
+  printf(GREEN"[PASS]"RESET" \"{:.670N}{:lld}\" within bound (compiled bound)\n");
+}
+
 int main(int argc, char **argv) {
   mach_timebase_info(&info);
 
   // basic
   fmt_test_case("Hello, world!", "Hello, world!");
   fmt_test_case("Hello, world!", "{:s}", "Hello, world!");
+  fmt_test_case("hi|hel|(null)", "{:.5s}|{:.3s}|{:.2s}", "hi", "hello", NULL);
   fmt_test_case("42", "{:d}", 42);
   fmt_test_case("2a", "{:x}", 42);
   fmt_test_case("3.14", "{:.2f}", 3.14);
@@ -67,9 +717,31 @@ int main(int argc, char **argv) {
   fmt_test_case("42, 3.14", "{1:d}, {0:.2f}", 3.14, 42);
   fmt_test_case("3.14, string, 42", "{0:.2f}, {2:s}, {1:d}", 3.14, 42, "string");
 
+  // many specifiers in two-pass mode
+#define X4(s) s s s s
+  fmt_test_case("21" X4(X4(X4("1"))), "{1:d}{0:d}" X4(X4(X4("{0:d}"))), 1, 2);
+  fmt_test_case("2 1|{bad type: q}", "{1:d} %d|{2:q}", 1, 2);
+  fmt_scratch_test_case("12 1 2 3 4 5 6 7 8 9 10 11 12", "{11:d} {:d} {:d} {:d} {:d} {:d} {:d} {:d} {:d} {:d} {:d} {:d} {:d}",
+                        1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12);
+
   // flags
   fmt_test_case("0x2a", "{:#x}", 42);
   fmt_test_case("2A", "{:!x}", 42);
+  fmt_test_case("21i3v9, 21I3V9, 8m0Kx", "{0:r36}, {0:R36}, {0:r62}", 123456789);
+  fmt_test_case("12.34, -0.000005, 42", "{:.2k}, {:.6llk}, {:llk}", 1234, -5ll, 42ll);
+  fmt_test_case("-92233720368547758.08|-0000.050", "{:.2llk}|%09.3k", INT64_MIN, -50);
+  fmt_test_case("1.050000|-1.5|0.100000000000|0.12|10.00", "{:f}|{:+.1f}|{:.12f}|{:.2f}|{:.2f}", 1.05, -1.5, 0.1, 0.125, 9.999);
+  fmt_test_case("10000000000000000905969664.000|-0000002.50|10", "{:.3f}|{:011.2f}|{:#.2f}", 1e25, -2.5, 9.999);
+  fmt_test_case("1.234560e+02|1.23E-05|-01.50e+00|1e+06", "{:e}|{:.2E}|{:010.2e}|{:#e}", 123.456, 1.2345e-5, -1.5, 1e6);
+  fmt_test_case("0.3|1E-45|1.67772e+07|0.300", "{:hg}|{:hG}|%hg|{:.3hf}", 0.3f, 1e-45f, 16777216.f, 0.3f);
+  fmt_test_case("0.0001|1.235e+05|100.0|1e-05|1E+20", "{:.3g}|{:.4g}|{:#.4g}|%g|%G", 0.0001, 123456.0, 100.0, 1e-5, 1e20);
+  fmt_test_case("0.1, 123.456, 1e+100, 5e-324, -0", "{:g}, {:g}, {:g}, {:g}, {:g}", 0.1, 123.456, 1e100, 5e-324, -0.0);
+  fmt_test_case("1.7976931348623157E+308|0.30000000000000004|100.0|0.0001|1e-05", "{:G}|{:g}|{:#g}|{:g}|{:g}",
+                1.7976931348623157e308, 0.1 + 0.2, 100.0, 1e-4, 1e-5);
+  fmt_test_case("0x1.8p+1|0X1.999999999999AP-4|0x1p+0|-0x0p+0|0x0.0000000000001p-1022", "{:a}|{:A}|{:a}|{:a}|%a",
+                3.0, 0.1, 1.0, -0.0, 5e-324);
+  fmt_test_case("0x2.0p+0|0x1.99ap-4|0x1p+0|+0x0001.8p+1|0X1.99999AP-4", "{:.1a}|{:.3a}|{:#.2a}|{:+012a}|{:!ha}",
+                1.99, 0.1, 1.0, 3.0, 0.1f);
   fmt_test_case("007", "{:03d}", 7);
   fmt_test_case("-007", "{:04d}", -7);
   fmt_test_case("+007", "{:+04d}", 7);
@@ -88,6 +760,44 @@ int main(int argc, char **argv) {
   fmt_test_case("............101", "{:$.>*b}", 5, 15);
   fmt_test_case("101............", "{1:$.<*0b}", 15, 5);
   fmt_test_case("          ", "{:10}"); // zero-arg fill
+  fmt_test_case("      1234|abc     |   ff   |  -7", "{:>10d}|{:<8s}|{:^8x}|{:>4d}", 1234, "abc", 255, -7);
+
+  char small[6];
+  fmt_format_args("{:>8d}", small, sizeof(small), (fmt_arg_t[]) { fmt_arg_int32(42) }, 1);
+  fmt_check("truncated right aligned field", "     ", small);
+  char long_str[901];
+  char long_out[300];
+  char expected_long[300];
+  memset(long_str, 'x', 900);
+  long_str[900] = 0;
+  long_str[300] = 0;
+  memset(expected_long, ' ', 299);
+  expected_long[299] = 0;
+  fmt_format_args("{:>1000s}", long_out, sizeof(long_out), (fmt_arg_t[]) { fmt_arg_string(long_str) }, 1);
+  fmt_check("truncated field wider than 256 characters", expected_long, long_out);
+  long_str[300] = 'x';
+  memset(expected_long + 50, 'x', 249);
+  fmt_format_args("{:^1000s}", long_out, sizeof(long_out), (fmt_arg_t[]) { fmt_arg_string(long_str) }, 1);
+  fmt_check("truncated centered value longer than 256 characters", expected_long, long_out);
+  char wide[320];
+  char expected_wide[303] = "  ";
+  memset(expected_wide + 2, '0', 299);
+  expected_wide[301] = '1';
+  expected_wide[302] = 0;
+  fmt_format_args("{:>302.300d}", wide, sizeof(wide), (fmt_arg_t[]) { fmt_arg_int32(1) }, 1);
+  fmt_check("value wider than 256 characters", expected_wide, wide);
+  char padded[1024];
+  char expected_padded[1002];
+  memset(expected_padded, '*', 1000);
+  memcpy(expected_padded + 499, "42", 2);
+  memcpy(expected_padded + 1000, "|", 2);
+  fmt_format_args("{:$*^1000d}|", padded, sizeof(padded), (fmt_arg_t[]) { fmt_arg_int32(42) }, 1);
+  fmt_check("field wider than 256 characters", expected_padded, padded);
+
+  // literals
+  fmt_test_case("{escaped} 100% done}", "{{escaped}} 100%% done}}");
+  fmt_test_case("request handled by worker 7 after 42 retries, closing connection to upstream",
+                "request handled by worker {:d} after {:d} retries, closing connection to upstream", 7, 42);
 
   // printf
   fmt_test_case("42", "%d", 42);
@@ -97,5 +807,111 @@ int main(int argc, char **argv) {
   fmt_test_case("1, hi, f", "%d, %s, %x", 1, "hi", 15);
   fmt_test_case("->  <-", "-> %J <-", 1); // unknown format specifier
 
+  // typed arguments
+  fmt_args_test_case("42, 3.14", "{1:d}, {0:.2f}", (fmt_arg_t[]) { fmt_arg_double(3.14), fmt_arg_int32(42) }, 2);
+  fmt_args_test_case("-1, ffffffffffffffff", "{0:lld}, {0:llx}", (fmt_arg_t[]) { fmt_arg_int64(-1) }, 1);
+  fmt_args_test_case("  hi|", "{1:>*0s}|{2:d}", (fmt_arg_t[]) { fmt_arg_int32(4), fmt_arg_voidptr("hi") }, 2);
+  fmt_args_test_case("{bad type: s}|{bad type: lld}", "{0:s}|{1:lld}", (fmt_arg_t[]) { fmt_arg_int32(4), fmt_arg_double(1.0) }, 2);
+#if defined(__SIZEOF_INT128__)
+  test_uint128_t u128 = ((test_uint128_t) UINT64_MAX << 64) | UINT64_MAX;
+  test_uint128_t i128 = -((test_uint128_t) 1 << 100);
+  fmt_args_test_case("340282366920938463463374607431768211455, ffffffffffffffffffffffffffffffff", "{0:w128u}, {0:w128x}",
+                     (fmt_arg_t[]) { fmt_arg_voidptr(&u128) }, 1);
+  fmt_test_case("-1267650600228229401496703205376, 0o3777777776000000000000000000000000000000000", "%w128d, {0:#w128o}", &i128);
+  uint64_t big_limbs[] = { UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX };
+  fmt_bigint_t big = { .limbs = big_limbs, .count = 4, .negative = true };
+  fmt_bigint_t big_zero = { .limbs = big_limbs, .count = 0, .negative = true };
+  fmt_test_case("-115792089237316195423570985008687907853269984665640564039457584007913129639935|    0",
+                "{:N}|{:>5N}", &big, &big_zero);
+#endif
+
+  char provider_buffer[64];
+  int provider_args = 3;
+  fmt_format_provider("{2:d} {:d} {:d} {:d}", provider_buffer, sizeof(provider_buffer), FMT_MAX_ARGS, test_provider, &provider_args);
+  fmt_check("provider", "20 0 10 20", provider_buffer);
+
+  // generic arguments
+  char typed_data[128];
+  fmt_buffer_t typed = fmtlib_buffer(typed_data, sizeof(typed_data));
+  fmt_write_typed(&typed, "{} {} {} {}|{:>4}|{:x} {:s}", 42, -7ll, (unsigned char) 200, (char) 'c', "hi", UINT64_MAX, "end");
+  fmt_check("typed", "42 -7 200 c|  hi|ffffffffffffffff end", typed_data);
+  typed = fmtlib_buffer(typed_data, sizeof(typed_data));
+  fmt_write_typed(&typed, "no args");
+  fmt_check("typed", "no args", typed_data);
+  typed = fmtlib_buffer(typed_data, sizeof(typed_data));
+  fmt_write_typed(&typed, "{} {:>6}", 0.1, 2.5);
+  fmt_check("typed", "0.1    2.5", typed_data);
+  typed = fmtlib_buffer(typed_data, sizeof(typed_data));
+  fmt_write_typed(&typed, "{} {:g} {:.3hf}", 0.1f, 0.1f, 0.1f);
+  fmt_check("typed", "0.1 0.10000000149011612 0.100", typed_data);
+  typed = fmtlib_buffer(typed_data, sizeof(typed_data));
+  fmt_write_typed(&typed, "{:s}|{:f}|{:d}|{:x}|{:p}", 42, "hi", 1.5, 'c', 2.5);
+  fmt_check("typed", "{bad type: s}|{bad type: f}|{bad type: d}|63|{bad type: p}", typed_data);
+
+  // arrays
+  char array_data[128];
+  int32_t array_values[] = { 0, -1, 7, 42, 99999999, 100000000, -2147483647 - 1, 12345 };
+  fmt_buffer_t array = fmtlib_buffer(array_data, sizeof(array_data));
+  fmt_write_array(&array, "{:d}", array_values, 8, ", ");
+  fmt_check("array", "0, -1, 7, 42, 99999999, 100000000, -2147483648, 12345", array_data);
+  uint64_t array_large[] = { UINT64_MAX, 10000000000000000ull, 9999999999999999ull, 1 };
+  array = fmtlib_buffer(array_data, sizeof(array_data));
+  fmt_write_array(&array, "{:llu}", array_large, 4, " ");
+  fmt_check("array", "18446744073709551615 10000000000000000 9999999999999999 1", array_data);
+  array = fmtlib_buffer(array_data, sizeof(array_data));
+  fmt_write_array(&array, "[{:>3x}]", array_values + 2, 4, "");
+  fmt_check("array", "[  7][ 2a][5f5e0ff][5f5e100]", array_data);
+  float array_floats[] = { 0.1f, -2.5f, 1e10f, 3.4028235e38f };
+  array = fmtlib_buffer(array_data, sizeof(array_data));
+  fmt_write_array(&array, "{:hg}", array_floats, 4, ", ");
+  fmt_check("array", "0.1, -2.5, 10000000000, 3.4028235e+38", array_data);
+
+  // compiled
+  fmt_compiled_test_case("Hello, world!", "Hello, world!");
+  fmt_compiled_test_case("42", "{:d}", 42);
+  fmt_compiled_test_case("3.14, string, 42", "{0:.2f}, {2:s}, {1:d}", 3.14, 42, "string");
+  fmt_compiled_test_case("............101", "{:$.>*b}", 5, 15);
+  fmt_compiled_test_case("{42} 100%", "{{{:d}}} 100%%", 42);
+  fmt_compiled_test_case("x{bad type: q}y", "x{:q}y", 1);
+  fmt_compiled_test_case("1, hi, f", "%d, %s, %x", 1, "hi", 15);
+  fmt_compiled_test_case("[   -42|0x002a|+7  |0b101]", "[{:>6d}|{:#06x}|{:<+4d}|{:#b}]", -42, 42, 7, 5);
+  fmt_compiled_bound_test();
+  fmt_static_test_case();
+  fmt_append_test_case();
+  fmt_printf_double_test();
+  fmt_shortest_round_trip_test(argc > 1 && strcmp(argv[1], "--exhaustive") == 0);
+  fmt_double_bench();
+  fmt_float_bench();
+  fmt_array_bench();
+  fmt_parse_bench();
+  fmt_integer_bench("{:llu}", "13333333333333333333");
+  fmt_integer_bench("{:llx}", "b90984060d355555");
+  fmt_integer_bench("{:#llX}", "0XB90984060D355555");
+  fmt_integer_bench("{:llb}", "1011100100001001100001000000011000001101001101010101010101010101");
+  fmt_integer_bench("{:llr36}", "2tatc79axp36d");
+  fmt_integer_bench("{:llr62}", "fSWO6qmFbV3");
+#if defined(__SIZEOF_INT128__)
+  fmt_int128_bench();
+  fmt_bigint_bench();
+  fmt_bigint_large_test();
+#endif
+
+  // cache
+  FMT_CACHE_DEFINE(cache, 16, 64);
+  fmt_cache_install(&cache);
+  fmt_test_case("42", "{:d}", 42);
+  fmt_test_case("42, 3.14", "{1:d}, {0:.2f}", 3.14, 42);
+  fmt_test_case("............101", "{:$.>*b}", 5, 15);
+  fmt_cache_install(NULL);
+
+  size_t expected_hits = 3 * BENCH_ITERATIONS;
+  if (cache.misses != 3 || cache.hits != expected_hits) {
+    printf(RED"[FAIL]"RESET" cache stats\n");
+    printf("  expected: %zu hits, 3 misses\n", expected_hits);
+    printf("  actual:   %zu hits, %zu misses\n", cache.hits, cache.misses);
+  } else {
+    printf(GREEN"[PASS]"RESET" cache stats: %zu hits, %zu misses\n", cache.hits, cache.misses);
+  }
+
   return 0;
 }